@@ -2,6 +2,139 @@
 #include <cmath>
 #include <iostream>
 
+// -DBEAMLINE_SIMD_VEC3=ON keeps Vec3 in an aligned 4-float SSE/NEON register.
+// Every lane operation rounds like the scalar code, so images are bit-exact
+// with the scalar build. -DBEAMLINE_SIMD_FMA=ON also fuses the multiply-adds
+// in cross() and normalizes with an rsqrt estimate; that is faster but
+// differs in the last bits. The NEON path needs AArch64 (vdivq_f32,
+// vfmaq_f32); 32-bit ARM builds keep the scalar Vec3.
+#if defined(BEAMLINE_SIMD_VEC3) && BEAMLINE_SIMD_VEC3 && defined(__ARM_NEON) && \
+    (defined(__aarch64__) || defined(_M_ARM64))
+#define BEAMLINE_VEC3_NEON 1
+#include <arm_neon.h>
+#elif defined(BEAMLINE_SIMD_VEC3) && BEAMLINE_SIMD_VEC3 && (defined(__SSE2__) || defined(_M_X64))
+#define BEAMLINE_VEC3_SSE 1
+#include <immintrin.h>
+#endif
+
+#if defined(BEAMLINE_VEC3_SSE) || defined(BEAMLINE_VEC3_NEON)
+
+namespace vec3_simd {
+#if defined(BEAMLINE_VEC3_NEON)
+using f4 = float32x4_t;
+inline f4 splat(float s) { return vdupq_n_f32(s); }
+inline f4 set(float x, float y, float z) {
+    float32x4_t v = vdupq_n_f32(0.f);
+    return vsetq_lane_f32(z, vsetq_lane_f32(y, vsetq_lane_f32(x, v, 0), 1), 2);
+}
+inline f4 add(f4 a, f4 b) { return vaddq_f32(a, b); }
+inline f4 sub(f4 a, f4 b) { return vsubq_f32(a, b); }
+inline f4 mul(f4 a, f4 b) { return vmulq_f32(a, b); }
+inline f4 div(f4 a, f4 b) { return vdivq_f32(a, b); }
+#if defined(BEAMLINE_SIMD_FMA) && BEAMLINE_SIMD_FMA
+inline f4 fmadd(f4 a, f4 b, f4 c) { return vfmaq_f32(c, a, b); }     // a * b + c
+inline f4 fnmadd(f4 a, f4 b, f4 c) { return vfmsq_f32(c, a, b); }    // c - a * b
+#else
+inline f4 fmadd(f4 a, f4 b, f4 c) { return vaddq_f32(vmulq_f32(a, b), c); }
+inline f4 fnmadd(f4 a, f4 b, f4 c) { return vsubq_f32(c, vmulq_f32(a, b)); }
+#endif
+inline f4 yzx(f4 v) {
+    float32x4_t r = vextq_f32(v, v, 1);                     // y z w x
+    return vsetq_lane_f32(vgetq_lane_f32(v, 0), r, 2);      // y z x x
+}
+inline float sum3(f4 v) { return vgetq_lane_f32(v, 0) + vgetq_lane_f32(v, 1) + vgetq_lane_f32(v, 2); }
+inline float rsqrt(float s) {
+    float32x2_t v = vdup_n_f32(s);
+    float32x2_t r = vrsqrte_f32(v);
+    r = vmul_f32(r, vrsqrts_f32(vmul_f32(v, r), r));
+    r = vmul_f32(r, vrsqrts_f32(vmul_f32(v, r), r));
+    return vget_lane_f32(r, 0);
+}
+#else
+using f4 = __m128;
+inline f4 splat(float s) { return _mm_set1_ps(s); }
+inline f4 set(float x, float y, float z) { return _mm_setr_ps(x, y, z, 0.f); }
+inline f4 add(f4 a, f4 b) { return _mm_add_ps(a, b); }
+inline f4 sub(f4 a, f4 b) { return _mm_sub_ps(a, b); }
+inline f4 mul(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+inline f4 div(f4 a, f4 b) { return _mm_div_ps(a, b); }
+#if defined(__FMA__) && defined(BEAMLINE_SIMD_FMA) && BEAMLINE_SIMD_FMA
+inline f4 fmadd(f4 a, f4 b, f4 c) { return _mm_fmadd_ps(a, b, c); }
+inline f4 fnmadd(f4 a, f4 b, f4 c) { return _mm_fnmadd_ps(a, b, c); }
+#else
+inline f4 fmadd(f4 a, f4 b, f4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline f4 fnmadd(f4 a, f4 b, f4 c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+#endif
+inline f4 yzx(f4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1)); }
+inline float sum3(f4 v) {
+    __m128 y = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 z = _mm_movehl_ps(v, v);
+    return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(v, y), z));
+}
+// ~12-bit estimate refined by one Newton step to ~23 bits
+inline float rsqrt(float s) {
+    float r = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(s)));
+    return r * (1.5f - 0.5f * s * r * r);
+}
+#endif
+}
+
+// x, y, z alias the register lanes (anonymous struct in a union, supported by
+// GCC, Clang and MSVC), so scalar code keeps working unchanged.
+struct alignas(16) Vec3 {
+    union {
+        vec3_simd::f4 m;
+        struct { float x, y, z, w; };   // w is padding and ignored
+    };
+
+    Vec3() : m(vec3_simd::splat(0.f)) {}
+    Vec3(float xx, float yy, float zz) : m(vec3_simd::set(xx, yy, zz)) {}
+    explicit Vec3(vec3_simd::f4 value) : m(value) {}
+
+    vec3_simd::f4 simd() const { return m; }
+
+    Vec3 operator+(const Vec3& v) const { return Vec3(vec3_simd::add(simd(), v.simd())); }
+    Vec3 operator-(const Vec3& v) const { return Vec3(vec3_simd::sub(simd(), v.simd())); }
+    Vec3 operator*(float s) const       { return Vec3(vec3_simd::mul(simd(), vec3_simd::splat(s))); }
+    Vec3 operator/(float s) const       { return Vec3(vec3_simd::div(simd(), vec3_simd::splat(s))); }
+    Vec3 operator*(const Vec3& v) const { return Vec3(vec3_simd::mul(simd(), v.simd())); }
+    bool operator==(const Vec3& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+    Vec3& operator+=(const Vec3& v) { return *this = *this + v; }
+    Vec3& operator*=(float s)       { return *this = *this * s; }
+
+    float length() const {
+        return std::sqrt(dot(*this));
+    }
+
+    // The bit-exact build divides at full precision: an rsqrt estimate moves
+    // shadow-ray and triangle-edge decisions enough to flip whole pixels
+    Vec3 normalized() const {
+#if defined(BEAMLINE_SIMD_FMA) && BEAMLINE_SIMD_FMA
+        float len2 = dot(*this);
+        if (len2 > 0) return *this * vec3_simd::rsqrt(len2);
+#else
+        float len = length();
+        if (len > 0) return *this / len;
+#endif
+        return Vec3(0, 0, 0);
+    }
+
+    float dot(const Vec3& v) const {
+        return vec3_simd::sum3(vec3_simd::mul(simd(), v.simd()));
+    }
+
+    // a.yzx * b.zxy - a.zxy * b.yzx, computed as (a * b.yzx - a.yzx * b).yzx
+    Vec3 cross(const Vec3& v) const {
+        vec3_simd::f4 a = simd(), b = v.simd();
+        vec3_simd::f4 ab = vec3_simd::mul(a, vec3_simd::yzx(b));
+        return Vec3(vec3_simd::yzx(vec3_simd::fnmadd(vec3_simd::yzx(a), b, ab)));
+    }
+};
+
+#else
+
 struct Vec3 {
     float x, y, z;
 
@@ -42,8 +175,10 @@ struct Vec3 {
     }
 };
 
+#endif
+
 // Optional: for easy printing
 inline std::ostream& operator<<(std::ostream& os, const Vec3& v) {
     os << "(" << v.x << ", " << v.y << ", " << v.z << ")";
     return os;
-}
\ No newline at end of file
+}
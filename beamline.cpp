@@ -5,14 +5,35 @@
 #include <ctime>
 #include <filesystem>
 #include <sstream>
+#include <fstream>
 #include <algorithm>
 #include <cstdlib>  // for std::system()
+#include <memory>
+#include <atomic>
+#include <csignal>
 #include "loader/SceneLoader.h"
 #include "cpu/RayTracer.h"
+#include "cpu/Relight.h"
+#include "cpu/RenderStats.h"
+#include "cpu/Trace.h"
+#include "cli/WatchMode.h"
+#include "cli/ServeMode.h"
+#include "cli/BatchMode.h"
+#include "net/Distributed.h"
 #include "image/ImageSaver.h"
+#include "image/VideoWriter.h"
 
 const std::string BEAMLINE_VERSION = "1.1.3500";
 
+// Set by SIGINT/SIGTERM; renders poll it and stop at the next scanline
+static std::atomic<bool> g_interrupted{false};
+
+extern "C" void handle_interrupt(int sig) {
+    g_interrupted = true;
+    // A second signal terminates immediately
+    std::signal(sig, SIG_DFL);
+}
+
 void print_banner() {
     std::cout << "\n";
     std::cout << "=======================================\n";
@@ -24,15 +45,56 @@ void print_banner() {
 
 void print_usage() {
     std::cout << "Usage:\n";
-    std::cout << "  beamline <scene.beam> [width height] [--out <file.ppm/png or pattern>]\n";
+    std::cout << "  beamline <scene.beam> [width height] [--out <file.ppm/png/y4m, pattern or - for stdout>]\n";
     std::cout << "           [--animate <seconds> <fps>] [--out-stitch [output.mp4]] [--info]\n";
+    std::cout << "           [--temporal [error_bound]] [--relight <cache.gbuf>] [--watch]\n";
+    std::cout << "           [--spp <n>] [--checkpoint <file.ckpt>] [--checkpoint-every <seconds>]\n";
+    std::cout << "           [--resume <file.ckpt>] [--workers <addr,addr,...>] [--tile-size <px>]\n";
+    std::cout << "           [--worker-timeout <seconds>] [--threads <n>] [--stats-json <file>]\n";
+    std::cout << "           [--trace <file.json>] [--cost-map <file.png>]\n";
+    std::cout << "           [--cost-metric time|tests|rays] [--uniform-tiles] [--seed <n>]\n";
+    std::cout << "           [--sampler independent|stratified|sobol|bluenoise] [--progress bar|quiet|json]\n";
+    std::cout << "           [--progress-fd <n>]\n";
+    std::cout << "           [--isa auto|avx512|avx2|generic] [--generic-tracer]\n";
+    std::cout << "           [--max-depth <n>] [--roulette <bounce>] [--min-contribution <weight>]\n";
+    std::cout << "           [--denoise] [--aovs <prefix>] [--guide]\n";
+    std::cout << "  beamline --worker <host:port | unix:/path.sock>\n";
+    std::cout << "  beamline --serve <host:port | unix:/path.sock> [--threads <n>] [--scene-root <dir>]\n";
+    std::cout << "  beamline --batch <jobs.txt> [--threads <n>]\n";
     std::cout << "\nExample:\n";
     std::cout << "  beamline scenes/test.beam 800 600\n";
     std::cout << "  beamline scenes/test.beam --out output.png\n";
     std::cout << "  beamline scenes/test.beam --animate 5 30 --out frame_%04d.png --out-stitch output.mp4\n";
+    std::cout << "  beamline scenes/test.beam --animate 5 30 --out - | ffmpeg -i - output.mp4\n";
+    std::cout << "  beamline scenes/test.beam --workers localhost:7000,unix:/tmp/w1.sock --out output.png\n";
     std::cout << "  beamline scenes/test.beam --info\n\n";
 }
 
+// Heatmap plus raw PFM next to it, and the most expensive tile for reference
+void write_cost_map(const CostMap& cost_map, const std::string& filename, const std::string& metric) {
+    if (!cost_map.saveHeatmap(filename, metric)) {
+        std::cerr << "[WARNING] Cost map heatmap was not saved: " << filename << "\n";
+    }
+    std::string raw = filename.substr(0, filename.find_last_of('.')) + ".pfm";
+    if (!cost_map.savePFM(raw)) {
+        std::cerr << "[WARNING] Raw cost data was not saved: " << raw << "\n";
+    }
+
+    Tile hottest;
+    double hottest_ns = -1.0, total_ns = 0.0;
+    for (const Tile& tile : make_tiles(cost_map.width, cost_map.height, 32)) {
+        double ns = cost_map.tileNanoseconds(tile);
+        total_ns += ns;
+        if (ns > hottest_ns) {
+            hottest_ns = ns;
+            hottest = tile;
+        }
+    }
+    std::cout << "Cost map: " << total_ns / 1e6 << " ms traced, max " << cost_map.maxNanoseconds() / 1e3
+              << " us/pixel, hottest 32x32 tile at (" << hottest.x0 << "," << hottest.y0 << ") "
+              << 100.0 * hottest_ns / std::max(total_ns, 1.0) << "% of total\n";
+}
+
 std::string get_timestamped_filename(const std::string& base) {
     std::time_t now = std::time(nullptr);
     std::tm* tm_info = std::localtime(&now);
@@ -45,8 +107,8 @@ void validate_scene(const Scene& scene) {
     if (scene.camera.position == scene.camera.lookat) {
         std::cerr << "[WARNING] Camera position and lookat are identical.\n";
     }
-    if (scene.lights.empty()) {
-        std::cerr << "[WARNING] No lights in scene. It will render black.\n";
+    if (scene.lights.empty() && !(scene_features(scene) & FEATURE_EMISSION)) {
+        std::cerr << "[WARNING] No lights or emissive objects in scene. It will render black.\n";
     }
     if (scene.spheres.empty() && scene.planes.empty()) {
         std::cerr << "[WARNING] Scene contains no geometry.\n";
@@ -58,6 +120,7 @@ void print_scene_summary(const Scene& scene, int width, int height) {
     std::cout << "Objects:      " << scene.spheres.size() << " spheres, "
               << scene.planes.size() << " planes\n";
     std::cout << "Lights:       " << scene.lights.size() << "\n";
+    std::cout << "Features:     " << scene_features_name(scene_features(scene)) << "\n";
     std::cout << "Camera Pos:   (" << scene.camera.position.x << ", "
               << scene.camera.position.y << ", " << scene.camera.position.z << ")\n";
     std::cout << "Camera Look:  (" << scene.camera.lookat.x << ", "
@@ -70,6 +133,13 @@ Vec3 lerp(const Vec3& a, const Vec3& b, float t) {
 }
 
 int main(int argc, char* argv[]) {
+    // A Y4M stream on stdout must stay clean, so console output moves to stderr
+    for (int i = 2; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--out" && std::string(argv[i + 1]) == "-") {
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
+    }
+
     print_banner();
 
     if (argc < 2) {
@@ -77,6 +147,37 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (std::string(argv[1]) == "--worker") {
+        if (argc < 3) {
+            print_usage();
+            return 1;
+        }
+        return run_worker(argv[2]);
+    }
+
+    if (std::string(argv[1]) == "--serve" || std::string(argv[1]) == "--batch") {
+        if (argc < 3) {
+            print_usage();
+            return 1;
+        }
+        bool serve = std::string(argv[1]) == "--serve";
+        int threads = 0;
+        std::string scene_root = ".";
+        for (int i = 3; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                threads = std::stoi(argv[++i]);
+            } else if (serve && arg == "--scene-root" && i + 1 < argc) {
+                scene_root = argv[++i];
+            } else {
+                std::cerr << "[ERROR] Unknown option for " << argv[1] << ": " << arg << "\n";
+                print_usage();
+                return 1;
+            }
+        }
+        return serve ? run_server(argv[2], threads, scene_root) : run_batch(argv[2], threads);
+    }
+
     std::string scene_file = argv[1];
     bool info_only = false;
     int width = 800, height = 600;
@@ -86,12 +187,37 @@ int main(int argc, char* argv[]) {
     bool animate = false;
     float anim_seconds = 0.0f;
     int anim_fps = 30;
+    bool temporal = false;
+    float temporal_bound = 0.01f;
+    std::string relight_cache;
+    bool watch = false;
+    int spp = 1;
+    bool spp_set = false;
+    std::string checkpoint_file;
+    double checkpoint_interval = 60.0;
+    std::string resume_file;
+    DistributedOptions distributed;
+    int threads = 0;
+    std::string stats_json;
+    std::string trace_file;
+    std::string cost_map_file;
+    std::string cost_metric = "time";
+    bool uniform_tiles = false;
+    bool generic_tracer = false;
+    int max_depth = 4;
+    int roulette = 3;
+    float min_contribution = 0.001f;
+    bool termination_set = false;
+    bool denoise_output = false;
+    std::string aov_prefix;
+    bool path_guiding = false;
+    uint32_t seed = 0;
+    bool seed_set = false;
+    SamplerType sampler = SamplerType::Stratified;
+    bool sampler_set = false;
 
     // Camera override
-    bool camera_pos_override = false;
-    bool camera_look_override = false;
-    Vec3 camera_pos_override_val;
-    Vec3 camera_look_override_val;
+    CameraOverride camera_override;
 
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -111,8 +237,8 @@ int main(int argc, char* argv[]) {
             float x, y, z;
             char comma1, comma2;
             if (ss >> x >> comma1 >> y >> comma2 >> z && comma1 == ',' && comma2 == ',') {
-                camera_pos_override_val = Vec3{x, y, z};
-                camera_pos_override = true;
+                camera_override.position = Vec3{x, y, z};
+                camera_override.has_position = true;
             } else {
                 std::cerr << "[ERROR] Invalid format for --camera-pos. Use x,y,z\n";
                 return 1;
@@ -123,8 +249,8 @@ int main(int argc, char* argv[]) {
             float x, y, z;
             char comma1, comma2;
             if (ss >> x >> comma1 >> y >> comma2 >> z && comma1 == ',' && comma2 == ',') {
-                camera_look_override_val = Vec3{x, y, z};
-                camera_look_override = true;
+                camera_override.lookat = Vec3{x, y, z};
+                camera_override.has_lookat = true;
             } else {
                 std::cerr << "[ERROR] Invalid format for --camera-look. Use x,y,z\n";
                 return 1;
@@ -137,6 +263,113 @@ int main(int argc, char* argv[]) {
                 std::cerr << "[ERROR] Invalid animation parameters.\n";
                 return 1;
             }
+        } else if (arg == "--temporal") {
+            temporal = true;
+            // Optional error bound, relative to hit distance
+            if (i + 1 < argc && (isdigit(argv[i + 1][0]) || argv[i + 1][0] == '.')) {
+                temporal_bound = std::stof(argv[++i]);
+            }
+        } else if (arg == "--spp" && i + 1 < argc) {
+            spp = std::stoi(argv[++i]);
+            spp_set = true;
+            if (spp <= 0) {
+                std::cerr << "[ERROR] --spp must be positive.\n";
+                return 1;
+            }
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpoint_file = argv[++i];
+        } else if (arg == "--checkpoint-every" && i + 1 < argc) {
+            checkpoint_interval = std::stod(argv[++i]);
+        } else if (arg == "--resume" && i + 1 < argc) {
+            resume_file = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            std::istringstream list(argv[++i]);
+            std::string address;
+            while (std::getline(list, address, ',')) {
+                if (!address.empty()) distributed.workers.push_back(address);
+            }
+        } else if (arg == "--tile-size" && i + 1 < argc) {
+            distributed.tileSize = std::stoi(argv[++i]);
+        } else if (arg == "--worker-timeout" && i + 1 < argc) {
+            distributed.timeoutSeconds = std::stoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+        } else if (arg == "--stats-json" && i + 1 < argc) {
+            stats_json = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_file = argv[++i];
+        } else if (arg == "--cost-map" && i + 1 < argc) {
+            cost_map_file = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = uint32_t(std::stoul(argv[++i]));
+            seed_set = true;
+        } else if (arg == "--sampler" && i + 1 < argc) {
+            if (!parse_sampler_type(argv[++i], sampler)) {
+                std::cerr << "[ERROR] --sampler must be independent, stratified, sobol or bluenoise.\n";
+                return 1;
+            }
+            sampler_set = true;
+        } else if (arg == "--progress" && i + 1 < argc) {
+            ProgressMode mode;
+            if (!parse_progress_mode(argv[++i], mode)) {
+                std::cerr << "[ERROR] --progress must be bar, quiet or json.\n";
+                return 1;
+            }
+            set_progress_mode(mode);
+        } else if (arg == "--progress-fd" && i + 1 < argc) {
+            int fd = std::stoi(argv[++i]);
+            if (fd < 0 || !set_progress_fd(fd)) {
+                std::cerr << "[ERROR] --progress-fd " << fd << " is not an open file descriptor.\n";
+                return 1;
+            }
+        } else if (arg == "--isa" && i + 1 < argc) {
+            std::string isa = argv[++i];
+            if (!select_kernels(isa)) {
+                std::cerr << "[ERROR] --isa " << isa << " is unknown or not supported by this CPU ("
+                          << cpu_feature_summary() << ").\n";
+                return 1;
+            }
+        } else if (arg == "--uniform-tiles") {
+            uniform_tiles = true;
+        } else if (arg == "--generic-tracer") {
+            generic_tracer = true;
+        } else if (arg == "--denoise") {
+            denoise_output = true;
+        } else if (arg == "--aovs" && i + 1 < argc) {
+            aov_prefix = argv[++i];
+        } else if (arg == "--guide") {
+            path_guiding = true;
+        } else if (arg == "--max-depth" && i + 1 < argc) {
+            max_depth = std::stoi(argv[++i]);
+            termination_set = true;
+            if (max_depth <= 0) {
+                std::cerr << "[ERROR] --max-depth must be positive.\n";
+                return 1;
+            }
+        } else if (arg == "--roulette" && i + 1 < argc) {
+            roulette = std::stoi(argv[++i]);
+            termination_set = true;
+            if (roulette < 0) {
+                std::cerr << "[ERROR] --roulette must be a bounce number, or 0 to disable.\n";
+                return 1;
+            }
+        } else if (arg == "--min-contribution" && i + 1 < argc) {
+            min_contribution = std::stof(argv[++i]);
+            termination_set = true;
+            if (min_contribution < 0.0f || min_contribution >= 1.0f) {
+                std::cerr << "[ERROR] --min-contribution must be in [0, 1).\n";
+                return 1;
+            }
+        } else if (arg == "--cost-metric" && i + 1 < argc) {
+            cost_metric = argv[++i];
+            if (cost_metric != "time" && cost_metric != "tests" && cost_metric != "rays") {
+                std::cerr << "[ERROR] --cost-metric must be time, tests or rays.\n";
+                return 1;
+            }
+        } else if (arg == "--watch") {
+            watch = true;
+        } else if (arg == "--relight" && i + 1 < argc) {
+            relight_cache = argv[++i];
         } else if (arg == "--out-stitch") {
             out_stitch = true;
             // Optional filename
@@ -151,23 +384,56 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    if (!trace_file.empty()) trace_start(trace_file);
+
     auto load_start = std::chrono::high_resolution_clock::now();
-    Scene scene = load_scene_from_file(scene_file);
+    Scene scene;
+    {
+        TRACE_SCOPE("load", "parse_scene");
+        scene = load_scene_from_file(scene_file);
+    }
     auto load_end = std::chrono::high_resolution_clock::now();
 
     double load_time = std::chrono::duration<double>(load_end - load_start).count();
 
     // Override camera if flags set
-    if (camera_pos_override) {
-        scene.camera.position = camera_pos_override_val;
-    }
-    if (camera_look_override) {
-        scene.camera.lookat = camera_look_override_val;
-    }
-    // Validate camera position and lookat
-    if (scene.camera.position == scene.camera.lookat) {
-        std::cerr << "[WARNING] Camera position and lookat are identical. Adjusting lookat.\n";
-        scene.camera.lookat = scene.camera.position + Vec3{0, 0, -1};
+    camera_override.apply(scene);
+
+    // A checkpoint carries its own resolution and sample target
+    RenderCheckpoint resume;
+    if (!resume_file.empty()) {
+        if (!resume.load(resume_file)) {
+            return 1;
+        }
+        if (resume.sceneKey != scene_hash(scene)) {
+            std::cerr << "[ERROR] Checkpoint " << resume_file << " was made for a different scene or camera.\n";
+            return 1;
+        }
+        width = resume.accumulation.width;
+        height = resume.accumulation.height;
+        if (!spp_set) spp = int(resume.targetSamples);
+        // Finishing with another seed would mix two sample sequences
+        if (seed_set && seed != resume.seed) {
+            std::cerr << "[WARNING] Checkpoint was rendered with --seed " << resume.seed << "; keeping it.\n";
+        }
+        seed = resume.seed;
+        if (sampler_set && uint32_t(sampler) != resume.sampler) {
+            std::cerr << "[WARNING] Checkpoint was rendered with --sampler "
+                      << sampler_type_name(SamplerType(resume.sampler)) << "; keeping it.\n";
+        }
+        sampler = SamplerType(resume.sampler);
+        if (termination_set && (max_depth != resume.maxDepth || roulette != resume.rouletteBounce ||
+                                min_contribution != resume.minContribution)) {
+            std::cerr << "[WARNING] Checkpoint was rendered with --max-depth " << resume.maxDepth << " --roulette "
+                      << resume.rouletteBounce << " --min-contribution " << resume.minContribution
+                      << "; keeping them.\n";
+        }
+        max_depth = resume.maxDepth;
+        roulette = resume.rouletteBounce;
+        min_contribution = resume.minContribution;
+        if (checkpoint_file.empty()) checkpoint_file = resume_file;
+        std::cout << "Resuming from: " << resume_file << " (" << resume.accumulation.totalSamples()
+                  << " samples done)\n";
     }
 
     std::cout << "Scene loaded: " << scene_file << " (" << load_time << " sec)\n";
@@ -176,28 +442,213 @@ int main(int argc, char* argv[]) {
     print_scene_summary(scene, width, height);
 
     if (info_only) {
+        std::string built;
+        for (const std::string& isa : available_kernels()) built += " " + isa;
+        std::cout << "CPU features: " << cpu_feature_summary() << "\n";
+        std::cout << "Kernels:      " << active_kernels().name << " (built:" << built << ")\n";
         std::cout << "\n[INFO MODE] No rendering performed.\n";
         return 0;
     }
 
+    // --threads 1 keeps the whole render on the main thread
+    std::unique_ptr<ThreadPool> pool;
+    if (threads != 1) pool = std::make_unique<ThreadPool>(threads);
+
+    if (watch) {
+        std::string preview_file = output_filename.empty() ? "watch_preview.png" : output_filename;
+        if (is_y4m_output(preview_file)) {
+            std::cerr << "[ERROR] --watch writes preview images; use a .png or .ppm output.\n";
+            return 1;
+        }
+        WatchOptions watch_options;
+        watch_options.pool = pool.get();
+        watch_options.samplesPerPixel = spp;
+        watch_options.seed = seed;
+        watch_options.sampler = sampler;
+        watch_options.maxDepth = max_depth;
+        watch_options.rouletteBounce = roulette;
+        watch_options.minContribution = min_contribution;
+        return run_watch(scene_file, width, height, preview_file, camera_override, watch_options);
+    }
+
+    StatsReportInfo stats_info;
+    stats_info.scene = scene_file;
+    stats_info.width = width;
+    stats_info.height = height;
+    stats_info.samplesPerPixel = spp;
+    stats_info.seed = seed;
+    stats_info.sampler = sampler_type_name(sampler);
+    stats_info.kernels = active_kernels().name;
+    stats_info.features = generic_tracer ? scene_features_name(FEATURE_ALL) : scene_features_name(scene_features(scene));
+    stats_info.threads = pool ? pool->size() : 1;
+    stats_info.loadSeconds = load_time;
+    reset_render_stats();
+
     if (!animate) {
         std::cout << "\nRendering...\n";
         auto render_start = std::chrono::high_resolution_clock::now();
 
-        RayTracer tracer(width, height, 4);
-        tracer.render(scene);
-
-        auto render_end = std::chrono::high_resolution_clock::now();
-        double render_time = std::chrono::duration<double>(render_end - render_start).count();
-
         std::string output_file = output_filename.empty()
             ? get_timestamped_filename("output")
             : output_filename;
 
+        RayTracer tracer(width, height, max_depth);
+        tracer.setRoulette(roulette);
+        tracer.setMinContribution(min_contribution);
+        tracer.setThreadPool(pool.get());
+        tracer.setAdaptiveTiles(!uniform_tiles);
+        tracer.setSpecialized(!generic_tracer);
+        const std::vector<Vec3>* framebuffer = &tracer.getFramebuffer();
+        CostMap cost_map;
+        if (!cost_map_file.empty()) {
+            if (!relight_cache.empty() || !distributed.workers.empty()) {
+                std::cerr << "[WARNING] --cost-map only covers local renders; ignored with --relight/--workers.\n";
+                cost_map_file.clear();
+            } else {
+                tracer.setCostMap(&cost_map);
+            }
+        }
+        AovBuffer aovs;
+        if (denoise_output || !aov_prefix.empty()) {
+            if (!relight_cache.empty() || !distributed.workers.empty()) {
+                std::cerr << "[WARNING] --denoise/--aovs only cover local renders; ignored with --relight/--workers.\n";
+                denoise_output = false;
+                aov_prefix.clear();
+            } else {
+                tracer.setAovBuffer(&aovs);
+                if (!resume_file.empty()) aovs = resume.aovs;
+            }
+        }
+        if (path_guiding) {
+            if (!relight_cache.empty() || !distributed.workers.empty()) {
+                std::cerr << "[WARNING] --guide only covers local renders; ignored with --relight/--workers.\n";
+                path_guiding = false;
+            } else if (spp < 2) {
+                std::cerr << "[WARNING] --guide learns over passes and needs --spp 2 or more; ignored.\n";
+                path_guiding = false;
+            }
+            tracer.setPathGuiding(path_guiding);
+        }
+
+        // Checkpoints capture the accumulation state so the render can continue
+        // with --resume; an interrupted render always leaves one behind
+        auto write_checkpoint = [&](const std::string& path) {
+            RenderCheckpoint ckpt;
+            ckpt.sceneKey = scene_hash(scene);
+            ckpt.targetSamples = uint32_t(spp);
+            ckpt.seed = seed;
+            ckpt.sampler = uint32_t(sampler);
+            ckpt.maxDepth = max_depth;
+            ckpt.rouletteBounce = roulette;
+            ckpt.minContribution = min_contribution;
+            ckpt.accumulation = tracer.getAccumulation();
+            ckpt.aovs = aovs;
+            if (ckpt.save(path)) {
+                std::cout << "\n[OK] Checkpoint saved: " << path << " (" << ckpt.accumulation.totalSamples()
+                          << " samples)\n";
+            }
+        };
+        tracer.setSamplesPerPixel(spp);
+        tracer.setSeed(seed);
+        tracer.setSampler(sampler);
+        tracer.setCancelFlag(&g_interrupted);
+        std::signal(SIGINT, handle_interrupt);
+        std::signal(SIGTERM, handle_interrupt);
+        if (!resume_file.empty()) {
+            tracer.resumeFrom(resume.accumulation);
+        }
+        if (!checkpoint_file.empty()) {
+            auto last_checkpoint = std::chrono::steady_clock::now();
+            tracer.setPassCallback([&](int) {
+                auto now = std::chrono::steady_clock::now();
+                if (std::chrono::duration<double>(now - last_checkpoint).count() >= checkpoint_interval) {
+                    write_checkpoint(checkpoint_file);
+                    last_checkpoint = now;
+                }
+            });
+        }
+
+        // Relight mode reuses primary hits from the cache when camera and geometry match
+        std::unique_ptr<RelightSession> relight;
+        std::vector<Vec3> distributed_framebuffer;
+        {
+            TRACE_SCOPE("render", "render");
+            if (!distributed.workers.empty()) {
+                std::ifstream in(scene_file);
+                std::stringstream text;
+                text << in.rdbuf();
+                distributed.samplesPerPixel = spp;
+                distributed.maxDepth = max_depth;
+                distributed.rouletteBounce = roulette;
+                distributed.minContribution = min_contribution;
+                distributed.seed = seed;
+                distributed.sampler = sampler;
+                render_distributed(scene, text.str(), width, height, distributed, distributed_framebuffer);
+                framebuffer = &distributed_framebuffer;
+            } else if (!relight_cache.empty()) {
+                relight = std::make_unique<RelightSession>(scene, width, height, max_depth);
+                relight->setRoulette(roulette);
+                relight->setMinContribution(min_contribution);
+                relight->setThreadPool(pool.get());
+                relight->setSamplesPerPixel(spp);
+                relight->setSeed(seed);
+                relight->setSampler(sampler);
+                bool cached = relight->loadCache(relight_cache);
+                std::cout << (cached ? "Relighting from G-buffer: " : "Recording G-buffer: ") << relight_cache << "\n";
+                framebuffer = &relight->render();
+                if (!cached && !relight->saveCache(relight_cache)) {
+                    std::cerr << "[WARNING] Failed to save G-buffer: " << relight_cache << "\n";
+                }
+            } else {
+                tracer.render(scene);
+            }
+        }
+
+        if (g_interrupted && relight_cache.empty() && distributed.workers.empty()) {
+            std::cerr << "\n[WARNING] Interrupted, saving partial render.\n";
+            std::string path = checkpoint_file.empty() ? output_file + ".ckpt" : checkpoint_file;
+            write_checkpoint(path);
+            if (!is_y4m_output(output_file)) {
+                save_image(output_file, *framebuffer, width, height);
+            }
+            std::cout << "Continue with: --resume " << path << "\n";
+            trace_stop();
+            return 130;
+        }
+        if (!checkpoint_file.empty()) {
+            write_checkpoint(checkpoint_file);
+        }
+        if (const PathGuide* guide = tracer.getPathGuide()) {
+            std::cout << "Path guide: " << guide->iterations() << " iterations, " << guide->spatialLeaves()
+                      << " regions, " << guide->memoryBytes() / 1024 << " KB\n";
+        }
+
+        std::vector<Vec3> denoised;
+        if (denoise_output) {
+            auto denoise_start = std::chrono::high_resolution_clock::now();
+            denoise(*framebuffer, aovs, denoised, pool.get());
+            framebuffer = &denoised;
+            std::cout << "Denoised in " << std::chrono::duration<double>(
+                std::chrono::high_resolution_clock::now() - denoise_start).count() << " sec\n";
+        }
+
+        auto render_end = std::chrono::high_resolution_clock::now();
+        double render_time = std::chrono::duration<double>(render_end - render_start).count();
+
         std::cout << "Saving to: " << output_file << "\n";
 
         auto save_start = std::chrono::high_resolution_clock::now();
-        save_image(output_file, tracer.getFramebuffer(), width, height);
+        {
+            TRACE_SCOPE("image", "save");
+            if (is_y4m_output(output_file)) {
+                Y4MWriter video;
+                if (video.open(output_file, width, height, anim_fps)) {
+                    video.write_frame(*framebuffer);
+                }
+            } else {
+                save_image(output_file, *framebuffer, width, height);
+            }
+        }
         auto save_end = std::chrono::high_resolution_clock::now();
 
         double save_time = std::chrono::duration<double>(save_end - save_start).count();
@@ -208,6 +659,15 @@ int main(int argc, char* argv[]) {
         std::cout << "Render time:  " << render_time << " sec\n";
         std::cout << "Save image:   " << save_time   << " sec\n";
         std::cout << "Total:        " << (load_time + render_time + save_time) << " sec\n";
+        stats_info.renderSeconds = render_time;
+        stats_info.saveSeconds = save_time;
+
+        if (!cost_map_file.empty() && !cost_map.nanoseconds.empty()) {
+            write_cost_map(cost_map, cost_map_file, cost_metric);
+        }
+        if (!aov_prefix.empty()) {
+            aovs.save(aov_prefix);
+        }
 
     } else {
         // Animation mode
@@ -215,13 +675,47 @@ int main(int argc, char* argv[]) {
         std::cout << "\nAnimation mode: " << anim_seconds << "s @ " << anim_fps << "fps = "
                   << total_frames << " frames\n";
 
-        // We require output filename pattern to contain printf-style %d for frame index
-        if (output_filename.empty() || output_filename.find("%") == std::string::npos) {
-            std::cerr << "[ERROR] In animation mode, --out filename must contain a printf-style frame number pattern, e.g. frame_%04d.png\n";
+        // Frames either stream into a single Y4M file/stdout or go to numbered images,
+        // which require a printf-style %d pattern for the frame index
+        bool stream_video = is_y4m_output(output_filename);
+        if (!stream_video && (output_filename.empty() || output_filename.find("%") == std::string::npos)) {
+            std::cerr << "[ERROR] In animation mode, --out filename must contain a printf-style frame number pattern, e.g. frame_%04d.png, or be a .y4m file or - for stdout\n";
             return 1;
         }
 
-        RayTracer tracer(width, height, 4);
+        Y4MWriter video;
+        if (stream_video && !video.open(output_filename, width, height, anim_fps)) {
+            return 1;
+        }
+
+        RayTracer tracer(width, height, max_depth);
+        tracer.setRoulette(roulette);
+        tracer.setMinContribution(min_contribution);
+        tracer.setThreadPool(pool.get());
+        tracer.setAdaptiveTiles(!uniform_tiles);
+        tracer.setSpecialized(!generic_tracer);
+        tracer.setSamplesPerPixel(spp);
+        tracer.setSeed(seed);
+        tracer.setSampler(sampler);
+        if (temporal) {
+            tracer.setTemporalReuse(true, temporal_bound);
+            std::cout << "Temporal reuse enabled (error bound " << temporal_bound << ")\n";
+        }
+        if (!aov_prefix.empty()) {
+            std::cerr << "[WARNING] --aovs only applies to still images; ignored in animation mode.\n";
+        }
+        if (denoise_output && temporal) {
+            std::cerr << "[WARNING] --denoise does not combine with --temporal; frames are saved as rendered.\n";
+            denoise_output = false;
+        }
+        if (path_guiding && (temporal || spp < 2)) {
+            std::cerr << "[WARNING] --guide needs --spp 2 or more and no --temporal; ignored.\n";
+        } else {
+            tracer.setPathGuiding(path_guiding);
+        }
+        AovBuffer aovs;
+        std::vector<Vec3> denoised;
+        if (denoise_output) tracer.setAovBuffer(&aovs);
 
         // For demonstration, we animate camera.position linearly from start to end over frames
         Vec3 start_pos = scene.camera.position;
@@ -230,34 +724,66 @@ int main(int argc, char* argv[]) {
         Vec3 end_look = scene.camera.lookat;
 
         auto anim_start = std::chrono::high_resolution_clock::now();
+        double anim_save_time = 0.0;
 
         for (int frame = 0; frame < total_frames; ++frame) {
+            TRACE_SCOPE_ARGS("animation", "frame", {"frame", frame});
             float t = float(frame) / float(total_frames - 1);
             scene.camera.position = lerp(start_pos, end_pos, t);
             scene.camera.lookat = lerp(start_look, end_look, t);
 
+            tracer.setFrame(uint32_t(frame));
             tracer.render(scene);
+            if (temporal) {
+                std::cout << "Reused " << tracer.getReusedPixelCount() << " of "
+                          << width * height << " pixels from previous frame\n";
+            }
+
+            const std::vector<Vec3>* frame_image = &tracer.getFramebuffer();
+            if (denoise_output) {
+                denoise(*frame_image, aovs, denoised, pool.get());
+                frame_image = &denoised;
+            }
+
+            auto save_start = std::chrono::high_resolution_clock::now();
+            if (stream_video) {
+                if (!video.write_frame(*frame_image)) {
+                    return 1;
+                }
+                anim_save_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - save_start).count();
+                std::cout << "Rendered and streamed frame " << frame << "\n";
+                continue;
+            }
 
             char filename_buf[256];
             std::snprintf(filename_buf, sizeof(filename_buf), output_filename.c_str(), frame);
 
-            save_image(filename_buf, tracer.getFramebuffer(), width, height);
+            save_image(filename_buf, *frame_image, width, height);
+            anim_save_time += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - save_start).count();
 
             std::cout << "Rendered and saved frame " << frame << " to " << filename_buf << "\n";
         }
+        video.close();
 
         auto anim_end = std::chrono::high_resolution_clock::now();
         double anim_time = std::chrono::duration<double>(anim_end - anim_start).count();
         std::cout << "\nAnimation render time: " << anim_time << " sec\n";
+        stats_info.frames = total_frames;
+        stats_info.renderSeconds = anim_time - anim_save_time;
+        stats_info.saveSeconds = anim_save_time;
 
-        if (out_stitch) {
+        if (out_stitch && output_filename == "-") {
+            std::cerr << "[WARNING] --out-stitch ignored when streaming to stdout; pipe into an encoder instead.\n";
+        } else if (out_stitch) {
             std::cout << "Stitching frames into video: " << stitch_output << "\n";
 
-            // Compose ffmpeg command
-            std::string ffmpeg_cmd =
-                "ffmpeg -y -framerate " + std::to_string(anim_fps) +
-                " -i " + output_filename +
-                " -c:v libx264 -pix_fmt yuv420p " + stitch_output;
+            // Compose ffmpeg command; a Y4M stream already carries its frame rate
+            std::string ffmpeg_cmd = stream_video
+                ? "ffmpeg -y -i " + output_filename +
+                  " -c:v libx264 -pix_fmt yuv420p " + stitch_output
+                : "ffmpeg -y -framerate " + std::to_string(anim_fps) +
+                  " -i " + output_filename +
+                  " -c:v libx264 -pix_fmt yuv420p " + stitch_output;
 
             int ret = std::system(ffmpeg_cmd.c_str());
             if (ret != 0) {
@@ -268,6 +794,14 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!stats_json.empty() && write_stats_json(stats_json, stats_info, collect_render_stats())) {
+        std::cout << "[OK] Statistics written: " << stats_json << "\n";
+    }
+
+    if (!trace_file.empty() && trace_stop()) {
+        std::cout << "[OK] Trace written: " << trace_file << "\n";
+    }
+
     std::cout << "\nBeamline complete.\n";
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,377 @@
+// Microbenchmarks for the renderer's hot paths.
+//
+//   beamline_bench [--runs N] [--warmup N] [--filter substring] [--json [file]]
+//
+// Every benchmark runs its warmup iterations, then N timed runs; the table
+// reports median and p95 per run and throughput in items (rays, pixels,
+// bytes...) per second. --json writes the same data for scripts and CI.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../cpu/Intersect.h"
+#include "../cpu/Kernels.h"
+#include "../cpu/RayTracer.h"
+#include "../cpu/Relight.h"
+#include "../image/ImageSaver.h"
+#include "../image/VideoWriter.h"
+#include "../loader/SceneLoader.h"
+
+// Results are folded in here so the compiler can't drop the work
+static volatile float g_sink = 0.0f;
+
+struct BenchOptions {
+    int runs = 15;
+    int warmup = 3;
+    std::string filter;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string unit;
+    double itemsPerRun = 0;
+    double median = 0, p95 = 0, min = 0;   // seconds per run
+};
+
+// Small deterministic generator so every run sees the same inputs
+struct Lcg {
+    uint32_t state;
+    explicit Lcg(uint32_t seed) : state(seed) {}
+    float next() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+    float range(float lo, float hi) { return lo + (hi - lo) * next(); }
+};
+
+static std::vector<Ray> make_rays(size_t count) {
+    // Rays from a shell around the origin aimed near it, so roughly half hit
+    // the unit-sized primitives below
+    Lcg rng(1234);
+    std::vector<Ray> rays;
+    rays.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        Vec3 origin(rng.range(-4, 4), rng.range(-4, 4), rng.range(3, 5));
+        Vec3 target(rng.range(-1.5f, 1.5f), rng.range(-1.5f, 1.5f), rng.range(-1.5f, 1.5f));
+        rays.emplace_back(origin, target - origin);
+    }
+    return rays;
+}
+
+// Cornell-style room with one primitive of every kind
+static std::string bench_scene_text() {
+    return R"([Camera]
+position = 0 1 3
+lookat = 0 1 0
+
+[Light1]
+type = point
+position = 0 1.9 1
+color = 1 1 1
+
+[Light2]
+type = point
+position = -0.5 1.5 2
+color = 0.4 0.4 0.5
+
+[Floor]
+type = plane
+point = 0 0 0
+normal = 0 1 0
+diffuse = 0.8 0.8 0.8
+reflectivity = 0.0
+
+[Left]
+type = plane
+point = -1 0 0
+normal = 1 0 0
+diffuse = 0.8 0.1 0.1
+reflectivity = 0.0
+
+[Right]
+type = plane
+point = 1 0 0
+normal = -1 0 0
+diffuse = 0.1 0.8 0.1
+reflectivity = 0.0
+
+[Ball]
+type = sphere
+center = -0.4 0.4 0
+radius = 0.4
+diffuse = 0.9 0.9 0.9
+reflectivity = 0.3
+
+[Box]
+type = cube
+min = 0.1 0 -0.5
+max = 0.7 0.6 0.1
+diffuse = 0.7 0.7 0.2
+reflectivity = 0.0
+
+[Tri]
+type = triangle
+v0 = -0.8 1.2 -0.8
+v1 = 0.8 1.2 -0.8
+v2 = 0 1.9 -0.8
+diffuse = 0.2 0.3 0.9
+reflectivity = 0.5
+)";
+}
+
+// Many-object scene text for the parser benchmark
+static std::string large_scene_text(int spheres) {
+    std::ostringstream out;
+    out << bench_scene_text();
+    Lcg rng(99);
+    for (int i = 0; i < spheres; ++i) {
+        out << "\n[S" << i << "]\ntype = sphere\n"
+            << "center = " << rng.range(-1, 1) << " " << rng.range(0, 2) << " " << rng.range(-1, 0) << "\n"
+            << "radius = " << rng.range(0.01f, 0.1f) << "\n"
+            << "diffuse = " << rng.next() << " " << rng.next() << " " << rng.next() << "\n"
+            << "reflectivity = " << rng.range(0, 0.5f) << "\n";
+    }
+    return out.str();
+}
+
+static double percentile(std::vector<double> sorted, double p) {
+    size_t i = size_t(std::ceil(p * sorted.size())) - 1;
+    return sorted[std::min(i, sorted.size() - 1)];
+}
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : options(options) {}
+
+    void run(const std::string& name, const std::string& unit, double itemsPerRun, const std::function<void()>& fn) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+        for (int i = 0; i < options.warmup; ++i) fn();
+        std::vector<double> times;
+        for (int i = 0; i < options.runs; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+
+        BenchResult r;
+        r.name = name;
+        r.unit = unit;
+        r.itemsPerRun = itemsPerRun;
+        r.median = percentile(times, 0.5);
+        r.p95 = percentile(times, 0.95);
+        r.min = times.front();
+        results.push_back(r);
+
+        std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << r.median * 1e3 << std::setw(12) << r.p95 * 1e3
+                  << std::setw(14) << std::setprecision(2) << itemsPerRun / r.median / 1e6 << " M" << unit << "/s"
+                  << std::defaultfloat << std::endl;
+    }
+
+    void writeJson(std::ostream& out) const {
+        out << std::setprecision(10);
+        out << "{\n  \"runs\": " << options.runs << ",\n  \"warmup\": " << options.warmup << ",\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult& r = results[i];
+            out << "    {\"name\": \"" << r.name << "\", \"unit\": \"" << r.unit << "\", \"items_per_run\": "
+                << r.itemsPerRun << ", \"median_ns\": " << int64_t(r.median * 1e9) << ", \"p95_ns\": "
+                << int64_t(r.p95 * 1e9) << ", \"min_ns\": " << int64_t(r.min * 1e9) << ", \"items_per_sec\": "
+                << r.itemsPerRun / r.median << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    BenchOptions options;
+    std::vector<BenchResult> results;
+};
+
+template <class Primitive, class Kernel>
+static void bench_kernel(BenchRunner& runner, const std::string& name, const std::vector<Ray>& rays,
+                         const Primitive& prim, Kernel kernel) {
+    runner.run(name, "rays", double(rays.size()), [&] {
+        float acc = 0.0f;
+        for (const Ray& ray : rays) {
+            float t;
+            Vec3 hit, normal;
+            if (kernel(ray, prim, t, hit, normal)) acc += t + normal.x;
+        }
+        g_sink = g_sink + acc;
+    });
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    bool json = false;
+    std::string json_file;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--runs" && i + 1 < argc) {
+            options.runs = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            options.warmup = std::max(0, std::stoi(argv[++i]));
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--json") {
+            json = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') json_file = argv[++i];
+        } else {
+            std::cerr << "Usage: beamline_bench [--runs N] [--warmup N] [--filter substring] [--json [file]]\n";
+            return 1;
+        }
+    }
+
+    // With JSON on stdout the table goes to stderr
+    std::streambuf* stdout_buf = std::cout.rdbuf();
+    if (json && json_file.empty()) std::cout.rdbuf(std::cerr.rdbuf());
+
+    std::cout << std::left << std::setw(26) << "benchmark" << std::right << std::setw(12) << "median ms"
+              << std::setw(12) << "p95 ms" << std::setw(20) << "throughput" << "\n";
+
+    BenchRunner runner(options);
+    const size_t RAY_COUNT = 1 << 16;
+    std::vector<Ray> rays = make_rays(RAY_COUNT);
+
+    {
+        Lcg rng(7);
+        std::vector<Vec3> vectors(RAY_COUNT);
+        for (auto& v : vectors) v = Vec3(rng.range(-1, 1), rng.range(-1, 1), rng.range(-1, 1));
+        runner.run("vec3/normalized", "vecs", double(vectors.size()), [&] {
+            Vec3 acc;
+            for (const Vec3& v : vectors) acc += v.normalized();
+            g_sink = g_sink + acc.x;
+        });
+    }
+
+    Material mat;
+    mat.diffuse_color = Vec3(0.5f, 0.5f, 0.5f);
+    bench_kernel(runner, "intersect/sphere", rays, Sphere{Vec3(0, 0, 0), 1.0f, mat}, intersect_sphere);
+    bench_kernel(runner, "intersect/plane", rays, Plane{Vec3(0, -1, 0), Vec3(0, 1, 0), mat}, intersect_plane);
+    bench_kernel(runner, "intersect/cube", rays, Cube{Vec3(-1, -1, -1), Vec3(1, 1, 1), mat}, intersect_cube);
+    bench_kernel(runner, "intersect/triangle", rays,
+                 Triangle{Vec3(-1, -1, 0), Vec3(1, -1, 0), Vec3(0, 1, 0), mat}, intersect_triangle);
+
+    // Batch nearest-hit kernels, once per variant this CPU supports
+    {
+        Lcg rng(11);
+        Scene soup;
+        for (int i = 0; i < 256; ++i) {
+            soup.spheres.push_back({Vec3(rng.range(-4, 4), rng.range(-4, 4), rng.range(-4, 4)), rng.range(0.05f, 0.3f), mat});
+        }
+        for (int i = 0; i < 1024; ++i) {
+            Vec3 v0(rng.range(-4, 4), rng.range(-4, 4), rng.range(-4, 4));
+            soup.triangles.push_back({v0, v0 + Vec3(rng.range(-0.5f, 0.5f), rng.range(-0.5f, 0.5f), 0),
+                                      v0 + Vec3(0, rng.range(-0.5f, 0.5f), rng.range(-0.5f, 0.5f)), mat});
+        }
+        PackedScene packed;
+        packed.build(soup);
+        std::vector<Ray> subset(rays.begin(), rays.begin() + 4096);
+        for (const std::string& isa : available_kernels()) {
+            if (!select_kernels(isa)) continue;
+            const KernelSet& kernels = active_kernels();
+            runner.run("nearest/spheres/" + isa, "tests", double(subset.size()) * packed.sphereCount(), [&] {
+                int acc = 0;
+                for (const Ray& ray : subset) {
+                    float t = std::numeric_limits<float>::max();
+                    acc += kernels.nearestSphere(packed, ray, t);
+                }
+                g_sink = g_sink + float(acc);
+            });
+            runner.run("nearest/triangles/" + isa, "tests", double(subset.size()) * packed.triangleCount(), [&] {
+                int acc = 0;
+                for (const Ray& ray : subset) {
+                    float t = std::numeric_limits<float>::max();
+                    acc += kernels.nearestTriangle(packed, ray, t);
+                }
+                g_sink = g_sink + float(acc);
+            });
+        }
+        select_kernels("auto");
+    }
+
+    const int W = 320, H = 240;
+    Scene scene = load_scene_from_string(bench_scene_text());
+    {
+        CameraBasis camera(scene.camera, W, H);
+        runner.run("camera/primary_rays", "rays", double(W) * H, [&] {
+            float acc = 0.0f;
+            for (int y = 0; y < H; ++y) {
+                for (int x = 0; x < W; ++x) acc += camera.primaryRay(x + 0.5f, y + 0.5f).direction.z;
+            }
+            g_sink = g_sink + acc;
+        });
+    }
+
+    {
+        RayTracer tracer(W, H, 4);
+        tracer.setShowProgress(false);
+        runner.run("render/full", "pixels", double(W) * H, [&] {
+            tracer.render(scene);
+            g_sink = g_sink + tracer.getFramebuffer()[0].x;
+        });
+
+        // Shadow rays and reflections only, primary hits come from the G-buffer
+        RelightSession session(scene, W, H, 4);
+        session.setShowProgress(false);
+        session.render();
+        runner.run("render/shade", "pixels", double(W) * H, [&] {
+            g_sink = g_sink + session.render()[0].x;
+        });
+    }
+
+    {
+        std::string text = large_scene_text(500);
+        runner.run("parse/scene_500", "bytes", double(text.size()), [&] {
+            Scene parsed = load_scene_from_string(text);
+            g_sink = g_sink + float(parsed.spheres.size());
+        });
+    }
+
+    {
+        RayTracer tracer(W, H, 4);
+        tracer.setShowProgress(false);
+        tracer.render(scene);
+        const std::vector<Vec3>& fb = tracer.getFramebuffer();
+        std::vector<unsigned char> encoded;
+        for (const char* format : {"png", "ppm"}) {
+            runner.run(std::string("encode/") + format, "pixels", double(W) * H, [&] {
+                encode_image(format, fb, W, H, encoded);
+                g_sink = g_sink + float(encoded.size());
+            });
+        }
+
+        std::vector<float> r(W * H), g(W * H), b(W * H);
+        for (size_t i = 0; i < fb.size(); ++i) {
+            r[i] = fb[i].x;
+            g[i] = fb[i].y;
+            b[i] = fb[i].z;
+        }
+        std::vector<unsigned char> luma(W * H);
+        runner.run("encode/y4m_luma", "pixels", double(W) * H, [&] {
+            rgb_to_luma_row(r.data(), g.data(), b.data(), luma.data(), W * H);
+            g_sink = g_sink + luma[W * H / 2];
+        });
+    }
+
+    std::cout.rdbuf(stdout_buf);
+    if (json) {
+        if (json_file.empty()) {
+            runner.writeJson(std::cout);
+        } else {
+            std::ofstream out(json_file);
+            runner.writeJson(out);
+            std::cerr << "[OK] Wrote " << json_file << "\n";
+        }
+    }
+    return 0;
+}
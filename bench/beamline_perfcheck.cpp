@@ -0,0 +1,278 @@
+// Performance and image-equivalence gate.
+//
+//   beamline_perfcheck [--scenes dir] [--data dir] [--update] [--update-baseline]
+//                      [--min-psnr dB] [--max-error levels] [--tolerance fraction]
+//                      [--runs N] [--threads N] [--isa name]
+//
+// Renders every scene in the scenes directory plus fixed-seed generated
+// stress scenes at a fixed resolution. Each image is compared against the
+// 8-bit reference in <data>/references (PSNR and largest per-channel error)
+// and each throughput against <data>/baseline.txt. Exits non-zero when an
+// image deviates or throughput drops by more than the tolerance.
+//
+// --update rewrites the references and the baseline; --update-baseline only
+// the baseline, which is machine-specific and best kept per CI runner.
+// --isa runs the gate on one kernel variant; every variant must match the
+// same references.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../cpu/RayTracer.h"
+#include "../cpu/RenderStats.h"
+#include "../cpu/ThreadPool.h"
+#include "../image/ImageSaver.h"
+#include "../loader/SceneGenerator.h"
+#include "../loader/SceneLoader.h"
+
+#ifndef BEAMLINE_SOURCE_DIR
+#define BEAMLINE_SOURCE_DIR "."
+#endif
+
+namespace fs = std::filesystem;
+
+static const int CHECK_WIDTH = 160;
+static const int CHECK_HEIGHT = 120;
+static const double MIN_TIMING_SECONDS = 0.5;
+
+struct PerfCase {
+    std::string name;
+    Scene scene;
+    int spp = 1;
+};
+
+struct Image8 {
+    int width = 0, height = 0;
+    std::vector<unsigned char> pixels;   // RGB
+};
+
+static bool read_ppm(const std::string& filename, Image8& image) {
+    std::ifstream in(filename, std::ios::binary);
+    std::string magic;
+    int maxval = 0;
+    if (!(in >> magic >> image.width >> image.height >> maxval) || magic != "P6" || maxval != 255) return false;
+    in.get();
+    image.pixels.resize(size_t(image.width) * image.height * 3);
+    return bool(in.read(reinterpret_cast<char*>(image.pixels.data()), image.pixels.size()));
+}
+
+static bool write_file(const std::string& filename, const std::vector<unsigned char>& data) {
+    std::ofstream out(filename, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return bool(out);
+}
+
+static std::vector<PerfCase> build_cases(const std::string& scenes_dir) {
+    std::vector<PerfCase> cases;
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::directory_iterator(scenes_dir)) {
+        if (entry.path().extension() == ".beam") files.push_back(entry.path());
+    }
+    std::sort(files.begin(), files.end());
+    for (const fs::path& file : files) {
+        PerfCase c;
+        c.name = file.stem().string();
+        c.scene = load_scene_from_file(file.string());
+        cases.push_back(c);
+    }
+
+    // Accumulation path and generated stress scenes, all fixed-seed
+    if (!cases.empty()) {
+        PerfCase multi = cases.front();
+        multi.name += "_spp4";
+        multi.spp = 4;
+        cases.push_back(multi);
+    }
+    struct Stress { const char* name; int spheres, triangles, lights; float reflective; uint32_t seed; };
+    const Stress stress[] = {
+        {"gen_mixed", 96, 256, 3, 0.3f, 7},
+        {"gen_many_lights", 32, 64, 8, 0.1f, 11},
+        {"gen_mirrors", 48, 32, 1, 0.9f, 23},
+    };
+    for (const Stress& s : stress) {
+        SceneGenParams params;
+        params.spheres = s.spheres;
+        params.triangles = s.triangles;
+        params.lights = s.lights;
+        params.reflectiveFraction = s.reflective;
+        params.seed = s.seed;
+        PerfCase c;
+        c.name = s.name;
+        c.scene = load_scene_from_string(generate_scene_text(params));
+        cases.push_back(c);
+    }
+    return cases;
+}
+
+static std::map<std::string, double> read_baseline(const std::string& filename) {
+    std::map<std::string, double> baseline;
+    std::ifstream in(filename);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        std::string name;
+        double rate;
+        if (ss >> name >> rate) baseline[name] = rate;
+    }
+    return baseline;
+}
+
+int main(int argc, char* argv[]) {
+    std::string scenes_dir = std::string(BEAMLINE_SOURCE_DIR) + "/scenes";
+    std::string data_dir = std::string(BEAMLINE_SOURCE_DIR) + "/perf";
+    bool update_references = false, update_baseline = false;
+    double min_psnr = 40.0, tolerance = 0.15;
+    int max_error = 24, runs = 5, threads = 1;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--scenes" && has_value) scenes_dir = argv[++i];
+            else if (arg == "--data" && has_value) data_dir = argv[++i];
+            else if (arg == "--update") update_references = update_baseline = true;
+            else if (arg == "--update-baseline") update_baseline = true;
+            else if (arg == "--min-psnr" && has_value) min_psnr = std::stod(argv[++i]);
+            else if (arg == "--max-error" && has_value) max_error = std::stoi(argv[++i]);
+            else if (arg == "--tolerance" && has_value) tolerance = std::stod(argv[++i]);
+            else if (arg == "--runs" && has_value) runs = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--threads" && has_value) threads = std::stoi(argv[++i]);
+            else if (arg == "--isa" && has_value) {
+                std::string isa = argv[++i];
+                if (!select_kernels(isa)) {
+                    std::cerr << "[ERROR] Kernel variant " << isa << " is unknown or unsupported here.\n";
+                    return 1;
+                }
+            }
+            else throw std::invalid_argument(arg);
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Usage: beamline_perfcheck [--scenes dir] [--data dir] [--update] [--update-baseline]\n"
+                  << "                          [--min-psnr dB] [--max-error levels] [--tolerance fraction]\n"
+                  << "                          [--runs N] [--threads N] [--isa name]\n";
+        return 1;
+    }
+
+    std::string reference_dir = data_dir + "/references";
+    std::string baseline_file = data_dir + "/baseline.txt";
+    if (update_references) fs::create_directories(reference_dir);
+    std::map<std::string, double> baseline = read_baseline(baseline_file);
+    if (baseline.empty() && !update_baseline) {
+        std::cout << "[WARNING] No timing baseline at " << baseline_file
+                  << "; only images are checked (create one with --update-baseline).\n";
+    }
+
+    std::cout << "Kernels: " << active_kernels().name << "\n";
+    std::unique_ptr<ThreadPool> pool;
+    if (threads != 1) pool = std::make_unique<ThreadPool>(threads);
+
+    std::vector<PerfCase> cases = build_cases(scenes_dir);
+    std::cout << std::left << std::setw(20) << "case" << std::right << std::setw(10) << "PSNR dB" << std::setw(9)
+              << "max err" << std::setw(11) << "Mrays/s" << std::setw(11) << "baseline" << std::setw(9) << "delta"
+              << "  result\n";
+
+    int failures = 0;
+    std::ostringstream new_baseline;
+    new_baseline << "# beamline_perfcheck throughput baseline (Mrays/s, " << CHECK_WIDTH << "x" << CHECK_HEIGHT
+                 << ", " << (pool ? pool->size() : 1) << " thread(s))\n";
+
+    for (const PerfCase& c : cases) {
+        RayTracer tracer(CHECK_WIDTH, CHECK_HEIGHT, 4);
+        tracer.setShowProgress(false);
+        tracer.setSamplesPerPixel(c.spp);
+        tracer.setThreadPool(pool.get());
+
+        tracer.render(c.scene);   // warmup
+        reset_render_stats();
+        // At least --runs renders and MIN_TIMING_SECONDS in total, so tiny scenes aren't all noise
+        std::vector<double> times;
+        double elapsed = 0.0;
+        while (int(times.size()) < runs || elapsed < MIN_TIMING_SECONDS) {
+            auto start = std::chrono::steady_clock::now();
+            tracer.render(c.scene);
+            times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            elapsed += times.back();
+        }
+        // Fastest run: scheduling noise only ever adds time
+        double best = *std::min_element(times.begin(), times.end());
+        double rays_per_render = collect_render_stats().total.totalRays() / double(times.size());
+        double mrays = rays_per_render / best / 1e6;
+        new_baseline << c.name << " " << mrays << "\n";
+
+        std::vector<unsigned char> encoded;
+        encode_image("ppm", tracer.getFramebuffer(), CHECK_WIDTH, CHECK_HEIGHT, encoded);
+        std::string reference_file = reference_dir + "/" + c.name + ".ppm";
+        if (update_references) write_file(reference_file, encoded);
+
+        std::vector<std::string> problems;
+        Image8 reference;
+        double psnr = 0.0;
+        int worst = 0;
+        if (!read_ppm(reference_file, reference)) {
+            problems.push_back("no reference");
+        } else if (reference.width != CHECK_WIDTH || reference.height != CHECK_HEIGHT) {
+            problems.push_back("reference size differs");
+        } else {
+            const unsigned char* pixels = encoded.data() + (encoded.size() - reference.pixels.size());
+            double squared = 0.0;
+            for (size_t i = 0; i < reference.pixels.size(); ++i) {
+                int diff = std::abs(int(pixels[i]) - int(reference.pixels[i]));
+                squared += double(diff) * diff;
+                worst = std::max(worst, diff);
+            }
+            double mse = squared / reference.pixels.size();
+            psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+            if (psnr < min_psnr) problems.push_back("PSNR below " + std::to_string(int(min_psnr)));
+            if (worst > max_error) problems.push_back("max error above " + std::to_string(max_error));
+        }
+
+        auto base = baseline.find(c.name);
+        double delta = 0.0;
+        if (base != baseline.end() && !update_baseline) {
+            delta = mrays / base->second - 1.0;
+            if (delta < -tolerance) problems.push_back("throughput regressed");
+        }
+
+        std::cout << std::left << std::setw(20) << c.name << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(10) << psnr << std::setw(9) << worst << std::setw(11) << mrays;
+        if (base != baseline.end()) {
+            std::cout << std::setw(11) << base->second << std::setw(8) << std::showpos << delta * 100.0
+                      << std::noshowpos << "%";
+        } else {
+            std::cout << std::setw(11) << "-" << std::setw(9) << "-";
+        }
+        std::cout << std::defaultfloat << "  ";
+        if (problems.empty()) {
+            std::cout << "ok\n";
+        } else {
+            ++failures;
+            for (size_t i = 0; i < problems.size(); ++i) std::cout << (i ? ", " : "") << problems[i];
+            std::cout << "\n";
+        }
+    }
+
+    if (update_baseline) {
+        fs::create_directories(data_dir);
+        std::ofstream out(baseline_file);
+        out << new_baseline.str();
+        std::cout << "[OK] Baseline written: " << baseline_file << "\n";
+    }
+    if (update_references) std::cout << "[OK] References written to " << reference_dir << "\n";
+
+    if (failures) {
+        std::cerr << "[ERROR] " << failures << " of " << cases.size() << " perf checks failed.\n";
+        return 1;
+    }
+    std::cout << "[OK] All " << cases.size() << " perf checks passed.\n";
+    return 0;
+}
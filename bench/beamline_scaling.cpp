@@ -0,0 +1,143 @@
+// End-to-end scaling benchmark over generated scenes.
+//
+//   beamline_scaling [--sizes 16,64,256] [--lights 1,4] [--threads 1,4]
+//                    [--resolutions 160x120,320x240] [--spp N] [--runs N] [--csv file]
+//
+// For every combination the scene (N spheres + N triangles) is generated,
+// parsed (load time) and rendered (median of --runs). One row per
+// combination, so each column pair can be plotted as a curve; --csv writes
+// the same rows for plotting. Rays/sec counts primary, shadow and reflection rays.
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../cpu/RayTracer.h"
+#include "../cpu/RenderStats.h"
+#include "../cpu/ThreadPool.h"
+#include "../loader/SceneGenerator.h"
+#include "../loader/SceneLoader.h"
+
+struct Resolution {
+    int width, height;
+};
+
+static std::vector<int> parse_int_list(const std::string& text) {
+    std::vector<int> values;
+    std::istringstream ss(text);
+    for (std::string item; std::getline(ss, item, ',');) {
+        if (!item.empty()) values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+static std::vector<Resolution> parse_resolutions(const std::string& text) {
+    std::vector<Resolution> values;
+    std::istringstream ss(text);
+    for (std::string item; std::getline(ss, item, ',');) {
+        size_t x = item.find('x');
+        if (x == std::string::npos) throw std::invalid_argument(item);
+        values.push_back({std::stoi(item.substr(0, x)), std::stoi(item.substr(x + 1))});
+    }
+    return values;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    int hw = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<int> sizes = {16, 64, 256, 1024};
+    std::vector<int> light_counts = {1};
+    std::vector<int> thread_counts = {1};
+    if (hw > 1) thread_counts.push_back(hw);
+    std::vector<Resolution> resolutions = {{160, 120}, {320, 240}};
+    int spp = 1, runs = 3;
+    std::string csv_file;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--sizes" && has_value) sizes = parse_int_list(argv[++i]);
+            else if (arg == "--lights" && has_value) light_counts = parse_int_list(argv[++i]);
+            else if (arg == "--threads" && has_value) thread_counts = parse_int_list(argv[++i]);
+            else if (arg == "--resolutions" && has_value) resolutions = parse_resolutions(argv[++i]);
+            else if (arg == "--spp" && has_value) spp = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--runs" && has_value) runs = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--csv" && has_value) csv_file = argv[++i];
+            else throw std::invalid_argument(arg);
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Usage: beamline_scaling [--sizes 16,64,256] [--lights 1,4] [--threads 1,4]\n"
+                  << "                        [--resolutions 160x120,320x240] [--spp N] [--runs N] [--csv file]\n";
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!csv_file.empty()) {
+        csv.open(csv_file);
+        csv << "spheres,triangles,lights,threads,width,height,spp,load_ms,render_ms,rays_per_frame,mrays_per_sec\n";
+    }
+
+    std::cout << std::setw(8) << "N" << std::setw(8) << "lights" << std::setw(9) << "threads" << std::setw(11)
+              << "resolution" << std::setw(11) << "load ms" << std::setw(12) << "render ms" << std::setw(12)
+              << "Mrays/s" << "\n";
+
+    for (int n : sizes) {
+        for (int lights : light_counts) {
+            SceneGenParams params;
+            params.spheres = n;
+            params.triangles = n;
+            params.lights = lights;
+            std::string text = generate_scene_text(params);
+
+            auto load_start = std::chrono::steady_clock::now();
+            Scene scene = load_scene_from_string(text);
+            double load_time = seconds_since(load_start);
+
+            for (int threads : thread_counts) {
+                ThreadPool pool(threads);
+                for (const Resolution& res : resolutions) {
+                    RayTracer tracer(res.width, res.height, 4);
+                    tracer.setShowProgress(false);
+                    tracer.setSamplesPerPixel(spp);
+                    if (threads > 1) tracer.setThreadPool(&pool);
+
+                    reset_render_stats();
+                    std::vector<double> times;
+                    for (int r = 0; r < runs; ++r) {
+                        auto start = std::chrono::steady_clock::now();
+                        tracer.render(scene);
+                        times.push_back(seconds_since(start));
+                    }
+                    std::sort(times.begin(), times.end());
+                    double render_time = times[times.size() / 2];
+                    uint64_t rays = collect_render_stats().total.totalRays() / runs;
+                    double mrays = rays / render_time / 1e6;
+
+                    std::ostringstream resolution;
+                    resolution << res.width << "x" << res.height;
+                    std::cout << std::setw(8) << n << std::setw(8) << lights << std::setw(9) << threads
+                              << std::setw(11) << resolution.str() << std::fixed << std::setprecision(2)
+                              << std::setw(11) << load_time * 1e3 << std::setw(12) << render_time * 1e3
+                              << std::setw(12) << std::setprecision(3) << mrays << std::defaultfloat << std::endl;
+                    if (csv) {
+                        csv << scene.spheres.size() << "," << scene.triangles.size() << "," << lights << ","
+                            << threads << "," << res.width << "," << res.height << "," << spp << ","
+                            << load_time * 1e3 << "," << render_time * 1e3 << "," << rays << "," << mrays << "\n";
+                    }
+                }
+            }
+        }
+    }
+
+    if (csv) std::cerr << "[OK] Wrote " << csv_file << "\n";
+    return 0;
+}
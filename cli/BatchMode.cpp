@@ -0,0 +1,210 @@
+#include "BatchMode.h"
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include "../cpu/RayTracer.h"
+#include "../cpu/ThreadPool.h"
+#include "../image/ImageSaver.h"
+#include "../loader/SceneCache.h"
+
+struct BatchJob {
+    std::string scene;
+    std::string output;
+    int width = 800, height = 600;
+    int spp = 1;
+    int maxDepth = 4;
+    int rouletteBounce = 3;
+    float minContribution = 0.001f;
+    CameraOverride camera;
+    int line = 0;
+};
+
+static bool parse_vec3(const std::string& text, Vec3& v) {
+    std::istringstream ss(text);
+    char c1, c2;
+    return ss >> v.x >> c1 >> v.y >> c2 >> v.z && c1 == ',' && c2 == ',';
+}
+
+static bool parse_job(const std::string& text, BatchJob& job, std::string& problem) {
+    std::istringstream ss(text);
+    std::vector<std::string> tokens;
+    for (std::string token; ss >> token;) tokens.push_back(token);
+    if (tokens.size() < 2) {
+        problem = "expected <scene> <output>";
+        return false;
+    }
+    job.scene = tokens[0];
+    job.output = tokens[1];
+
+    std::string ext = job.output.substr(job.output.find_last_of('.') + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext != "png" && ext != "ppm") {
+        problem = "output must be .png or .ppm";
+        return false;
+    }
+
+    size_t i = 2;
+    try {
+        if (tokens.size() >= 4 && tokens[2][0] != '-') {
+            job.width = std::stoi(tokens[2]);
+            job.height = std::stoi(tokens[3]);
+            i = 4;
+        }
+        for (; i < tokens.size(); ++i) {
+            const std::string& arg = tokens[i];
+            bool has_value = i + 1 < tokens.size();
+            if (arg == "--camera-pos" && has_value) {
+                if (!parse_vec3(tokens[++i], job.camera.position)) {
+                    problem = "invalid --camera-pos, use x,y,z";
+                    return false;
+                }
+                job.camera.has_position = true;
+            } else if (arg == "--camera-look" && has_value) {
+                if (!parse_vec3(tokens[++i], job.camera.lookat)) {
+                    problem = "invalid --camera-look, use x,y,z";
+                    return false;
+                }
+                job.camera.has_lookat = true;
+            } else if (arg == "--spp" && has_value) {
+                job.spp = std::stoi(tokens[++i]);
+            } else if (arg == "--max-depth" && has_value) {
+                job.maxDepth = std::stoi(tokens[++i]);
+            } else if (arg == "--roulette" && has_value) {
+                job.rouletteBounce = std::stoi(tokens[++i]);
+            } else if (arg == "--min-contribution" && has_value) {
+                job.minContribution = std::stof(tokens[++i]);
+            } else {
+                problem = "unexpected '" + arg + "'";
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        problem = "invalid number";
+        return false;
+    }
+
+    if (job.width <= 0 || job.height <= 0 || job.spp <= 0) {
+        problem = "resolution and spp must be positive";
+        return false;
+    }
+    if (job.maxDepth <= 0) {
+        problem = "--max-depth must be positive";
+        return false;
+    }
+    if (job.rouletteBounce < 0) {
+        problem = "--roulette must be a bounce number, or 0 to disable";
+        return false;
+    }
+    if (!(job.minContribution >= 0.0f && job.minContribution < 1.0f)) {
+        problem = "--min-contribution must be in [0, 1)";
+        return false;
+    }
+    return true;
+}
+
+int run_batch(const std::string& manifest_file, int threads) {
+    std::ifstream in(manifest_file);
+    if (!in) {
+        std::cerr << "[ERROR] Couldn't open manifest: " << manifest_file << "\n";
+        return 1;
+    }
+
+    // The whole manifest is validated before anything is rendered
+    std::vector<BatchJob> jobs;
+    std::string line;
+    int line_number = 0;
+    bool valid = true;
+    while (std::getline(in, line)) {
+        ++line_number;
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+        BatchJob job;
+        job.line = line_number;
+        std::string problem;
+        if (!parse_job(line, job, problem)) {
+            std::cerr << "[ERROR] " << manifest_file << ":" << line_number << ": " << problem << "\n";
+            valid = false;
+            continue;
+        }
+        jobs.push_back(job);
+    }
+    if (!valid) return 1;
+    if (jobs.empty()) {
+        std::cerr << "[WARNING] No jobs in " << manifest_file << "\n";
+        return 0;
+    }
+
+    ThreadPool pool(threads);
+    SceneCache scenes;
+    std::cout << "Batch: " << jobs.size() << " jobs from " << manifest_file << " (" << pool.size() << " threads)\n";
+
+    // Saving runs below tile priority, overlapping with the next render
+    TaskGroup saves(pool, -1);
+    int failed = 0;
+    uint64_t total_samples = 0;
+    double total_render = 0.0;
+    auto batch_start = std::chrono::steady_clock::now();
+    std::atomic<int> failed_saves{0};
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BatchJob& job = jobs[i];
+        // Built up front and printed whole, since saves log from pool threads
+        std::ostringstream report;
+        report << "[" << (i + 1) << "/" << jobs.size() << "] " << job.output << " ";
+
+        auto load_start = std::chrono::steady_clock::now();
+        size_t misses = scenes.misses();
+        auto cached = scenes.get(job.scene);
+        double load_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - load_start).count();
+        if (!cached) {
+            std::cout << report.str() << "failed (line " << job.line << ")\n";
+            ++failed;
+            continue;
+        }
+        Scene scene = *cached;
+        job.camera.apply(scene);
+
+        auto render_start = std::chrono::steady_clock::now();
+        RayTracer tracer(job.width, job.height, job.maxDepth);
+        tracer.setRoulette(job.rouletteBounce);
+        tracer.setMinContribution(job.minContribution);
+        tracer.setShowProgress(false);
+        tracer.setSamplesPerPixel(job.spp);
+        tracer.setThreadPool(&pool);
+        tracer.render(scene);
+        double render_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - render_start).count();
+
+        total_render += render_time;
+        total_samples += uint64_t(job.width) * job.height * job.spp;
+        report << job.width << "x" << job.height << " spp " << job.spp << std::fixed << std::setprecision(3)
+               << "  render " << render_time << "s";
+        if (scenes.misses() != misses) report << "  load " << load_time << "s";
+        std::cout << report.str() << std::endl;
+
+        saves.run([fb = tracer.getFramebuffer(), job, &failed_saves] {
+            if (!save_image(job.output, fb, job.width, job.height)) {
+                std::cerr << "[ERROR] Job on line " << job.line << " rendered but was not saved\n";
+                ++failed_saves;
+            }
+        });
+    }
+    saves.wait();
+    failed += failed_saves.load();
+
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+    int done = int(jobs.size()) - failed;
+    std::cout << "\n[OK] Batch finished: " << done << "/" << jobs.size() << " jobs, "
+              << scenes.misses() << " scene(s) loaded\n";
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "  Wall time:   " << wall << " sec (" << total_render << " sec rendering)\n";
+    std::cout << "  Throughput:  " << (wall > 0 ? done / wall : 0.0) << " jobs/sec, "
+              << (wall > 0 ? total_samples / wall / 1e6 : 0.0) << " Msamples/sec\n";
+    std::cout << std::defaultfloat;
+    return failed ? 1 : 0;
+}
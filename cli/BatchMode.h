@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+
+// --batch: renders every job listed in a manifest from one process. Each
+// distinct scene file is parsed once and all jobs share one thread pool;
+// image encoding overlaps with the next job's render.
+//
+// Manifest lines mirror the command line ('#' starts a comment):
+//   <scene.beam> <output.png|ppm> [width height] [--camera-pos x,y,z] [--camera-look x,y,z] [--spp n]
+//                [--max-depth n] [--roulette bounce] [--min-contribution weight]
+int run_batch(const std::string& manifest_file, int threads);
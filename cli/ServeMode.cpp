@@ -0,0 +1,304 @@
+#include "ServeMode.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include "../cpu/RayTracer.h"
+#include "../cpu/ThreadPool.h"
+#include "../image/ImageSaver.h"
+#include "../loader/SceneCache.h"
+#include "../net/Socket.h"
+
+static const int DISPATCH_THREADS = 2;   // renders in flight; tiles of both share the pool
+static const int MAX_DIMENSION = 16384;
+static const int MAX_TRACE_DEPTH = 256;   // reflections recurse on the stack
+
+struct RenderJob {
+    std::string id;
+    std::string scene;
+    int width = 800, height = 600;
+    int spp = 1;
+    int maxDepth = 4;
+    int rouletteBounce = 3;
+    float minContribution = 0.001f;
+    int priority = 0;
+    std::string format = "png";
+    CameraOverride camera;
+
+    uint64_t seq = 0;
+    std::atomic<bool> cancelled{false};
+    int clientFd = -1;
+    std::shared_ptr<std::mutex> clientMutex;   // serializes replies on one connection
+};
+
+using JobPtr = std::shared_ptr<RenderJob>;
+
+struct JobOrder {
+    bool operator()(const JobPtr& a, const JobPtr& b) const {
+        return a->priority != b->priority ? a->priority < b->priority : a->seq > b->seq;
+    }
+};
+
+static bool parse_vec3(const std::string& text, Vec3& v) {
+    std::istringstream ss(text);
+    char c1, c2;
+    return ss >> v.x >> c1 >> v.y >> c2 >> v.z && c1 == ',' && c2 == ',';
+}
+
+// Buffered line reader over a socket
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd(fd) {}
+
+    bool readLine(std::string& line) {
+        for (;;) {
+            size_t nl = buffer.find('\n', start);
+            if (nl != std::string::npos) {
+                line = buffer.substr(start, nl - start);
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                start = nl + 1;
+                return true;
+            }
+            buffer.erase(0, start);
+            start = 0;
+            char chunk[4096];
+            long n = net_recv(fd, chunk, sizeof(chunk));
+            if (n <= 0) return false;
+            buffer.append(chunk, size_t(n));
+        }
+    }
+
+private:
+    int fd;
+    std::string buffer;
+    size_t start = 0;
+};
+
+class RenderServer {
+public:
+    RenderServer(int threads, const std::filesystem::path& sceneRoot) : pool(threads), sceneRoot(sceneRoot) {
+        for (int i = 0; i < DISPATCH_THREADS; ++i) {
+            std::thread(&RenderServer::dispatch, this).detach();
+        }
+    }
+
+    int threadCount() const { return pool.size(); }
+    void serveClient(int fd);
+
+private:
+    ThreadPool pool;
+    SceneCache scenes;
+    std::filesystem::path sceneRoot;   // canonical
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::priority_queue<JobPtr, std::vector<JobPtr>, JobOrder> queue;
+    std::unordered_map<std::string, std::weak_ptr<RenderJob>> jobsById;   // queued or running
+    uint64_t nextSeq = 0;
+
+    void dispatch();
+    void execute(RenderJob& job);
+    bool resolveScene(const std::string& requested, std::string& path) const;
+    void cancel(const std::string& id);
+    static void reply(RenderJob& job, const std::string& header, const std::vector<unsigned char>* body = nullptr);
+};
+
+void RenderServer::reply(RenderJob& job, const std::string& header, const std::vector<unsigned char>* body) {
+    std::lock_guard<std::mutex> lock(*job.clientMutex);
+    if (!net_send_all(job.clientFd, header.data(), header.size())) return;
+    if (body && !body->empty()) net_send_all(job.clientFd, body->data(), body->size());
+}
+
+void RenderServer::cancel(const std::string& id) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    auto it = jobsById.find(id);
+    if (it == jobsById.end()) return;
+    if (auto job = it->second.lock()) job->cancelled = true;
+}
+
+void RenderServer::dispatch() {
+    for (;;) {
+        JobPtr job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [&] { return !queue.empty(); });
+            job = queue.top();
+            queue.pop();
+        }
+        if (job->cancelled) {
+            reply(*job, "error " + job->id + " cancelled\n");
+        } else {
+            execute(*job);
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto it = jobsById.find(job->id);
+        if (it != jobsById.end() && it->second.lock() == job) jobsById.erase(it);
+    }
+}
+
+bool RenderServer::resolveScene(const std::string& requested, std::string& path) const {
+    std::filesystem::path relative(requested);
+    if (relative.empty() || relative.is_absolute() || relative.has_root_name()) return false;
+    for (const auto& part : relative) {
+        if (part == "..") return false;
+    }
+    std::error_code ec;
+    std::filesystem::path full = std::filesystem::weakly_canonical(sceneRoot / relative, ec);
+    if (ec) return false;
+    // Symlinks inside the root must not lead out of it either
+    auto mismatch = std::mismatch(sceneRoot.begin(), sceneRoot.end(), full.begin(), full.end());
+    if (mismatch.first != sceneRoot.end()) return false;
+    path = full.string();
+    return true;
+}
+
+void RenderServer::execute(RenderJob& job) {
+    auto start = std::chrono::steady_clock::now();
+    auto cached = scenes.get(job.scene);
+    if (!cached) {
+        reply(job, "error " + job.id + " cannot load scene " + job.scene + "\n");
+        return;
+    }
+    Scene scene = *cached;
+    job.camera.apply(scene);
+
+    RayTracer tracer(job.width, job.height, job.maxDepth);
+    tracer.setRoulette(job.rouletteBounce);
+    tracer.setMinContribution(job.minContribution);
+    tracer.setShowProgress(false);
+    tracer.setSamplesPerPixel(job.spp);
+    tracer.setThreadPool(&pool, job.priority);
+    tracer.setCancelFlag(&job.cancelled);
+    tracer.render(scene);
+    if (job.cancelled) {
+        reply(job, "error " + job.id + " cancelled\n");
+        return;
+    }
+
+    std::vector<unsigned char> encoded;
+    encode_image(job.format, tracer.getFramebuffer(), job.width, job.height, encoded);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[serve] " << job.id << ": " << job.scene << " " << job.width << "x" << job.height
+              << " spp " << job.spp << " -> " << encoded.size() << " bytes in " << seconds << "s" << std::endl;
+    reply(job, "ok " + job.id + " " + std::to_string(encoded.size()) + "\n", &encoded);
+}
+
+void RenderServer::serveClient(int fd) {
+    auto clientMutex = std::make_shared<std::mutex>();
+    auto send_error = [&](const std::string& id, const std::string& text) {
+        std::string line = "error " + (id.empty() ? std::string("-") : id) + " " + text + "\n";
+        std::lock_guard<std::mutex> lock(*clientMutex);
+        net_send_all(fd, line.data(), line.size());
+    };
+
+    LineReader reader(fd);
+    std::vector<JobPtr> submitted;
+    std::string line;
+    while (reader.readLine(line)) {
+        if (line.empty()) continue;
+
+        std::string command = line;
+        auto job = std::make_shared<RenderJob>();
+        std::string problem;
+        while (reader.readLine(line) && !line.empty()) {
+            std::istringstream ss(line);
+            std::string key, value;
+            ss >> key;
+            std::getline(ss >> std::ws, value);
+            try {
+                if (key == "id") job->id = value;
+                else if (key == "scene") job->scene = value;
+                else if (key == "width") job->width = std::stoi(value);
+                else if (key == "height") job->height = std::stoi(value);
+                else if (key == "spp") job->spp = std::stoi(value);
+                else if (key == "max-depth") job->maxDepth = std::stoi(value);
+                else if (key == "roulette") job->rouletteBounce = std::stoi(value);
+                else if (key == "min-contribution") job->minContribution = std::stof(value);
+                else if (key == "priority") job->priority = std::stoi(value);
+                else if (key == "format") job->format = value;
+                else if (key == "camera-pos") {
+                    if (!parse_vec3(value, job->camera.position)) problem = "invalid camera-pos";
+                    job->camera.has_position = true;
+                } else if (key == "camera-look") {
+                    if (!parse_vec3(value, job->camera.lookat)) problem = "invalid camera-look";
+                    job->camera.has_lookat = true;
+                } else {
+                    problem = "unknown field " + key;
+                }
+            } catch (const std::exception&) {
+                problem = "invalid value for " + key;
+            }
+        }
+
+        if (command == "cancel") {
+            cancel(job->id);
+            continue;
+        }
+        if (command != "render") problem = "unknown command " + command;
+        else if (job->id.empty()) problem = "missing id";
+        else if (job->scene.empty()) problem = "missing scene";
+        else if (!resolveScene(job->scene, job->scene)) problem = "scene must be a path inside the scene root";
+        else if (job->width <= 0 || job->height <= 0 || job->width > MAX_DIMENSION || job->height > MAX_DIMENSION)
+            problem = "invalid resolution";
+        else if (job->spp <= 0) problem = "spp must be positive";
+        else if (job->maxDepth <= 0 || job->maxDepth > MAX_TRACE_DEPTH)
+            problem = "max-depth must be between 1 and " + std::to_string(MAX_TRACE_DEPTH);
+        else if (job->rouletteBounce < 0) problem = "roulette must not be negative";
+        else if (!(job->minContribution >= 0.0f && job->minContribution < 1.0f))
+            problem = "min-contribution must be in [0, 1)";
+        else if (job->format != "png" && job->format != "ppm" && job->format != "raw")
+            problem = "unknown format " + job->format;
+        if (!problem.empty()) {
+            send_error(job->id, problem);
+            continue;
+        }
+
+        job->clientFd = fd;
+        job->clientMutex = clientMutex;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            job->seq = nextSeq++;
+            jobsById[job->id] = job;
+            queue.push(job);
+        }
+        queueReady.notify_one();
+        submitted.push_back(job);
+    }
+
+    // Nobody is left to receive the results
+    for (auto& job : submitted) job->cancelled = true;
+    // Replies still in flight hold the client mutex; close only once they are done
+    std::thread([fd, submitted = std::move(submitted)] {
+        for (auto& job : submitted) {
+            while (job.use_count() > 1) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        net_close(fd);
+    }).detach();
+}
+
+int run_server(const std::string& address, int threads, const std::string& sceneRoot) {
+    std::error_code ec;
+    std::filesystem::path root = std::filesystem::canonical(sceneRoot, ec);
+    if (ec || !std::filesystem::is_directory(root)) {
+        std::cerr << "[ERROR] Scene root is not a directory: " << sceneRoot << "\n";
+        return 1;
+    }
+    int listenFd = net_listen(address);
+    if (listenFd < 0) return 1;
+
+    RenderServer server(threads, root);
+    std::cout << "Render server listening on " << address << " (" << server.threadCount() << " threads, scenes from "
+              << root.string() << ")\n";
+    for (;;) {
+        int fd = net_accept(listenFd);
+        if (fd < 0) continue;
+        std::thread(&RenderServer::serveClient, &server, fd).detach();
+    }
+}
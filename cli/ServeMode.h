@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+
+// --serve: long-running render daemon. Parsed scenes stay cached between
+// requests (keyed by path, revalidated by mtime and content hash) and all
+// renders share one thread pool, so repeated requests skip startup, parsing
+// and thread creation.
+//
+// Protocol (one request per block, text lines terminated by a blank line):
+//
+//   render                      cancel
+//   id <name>                   id <name>
+//   scene <path.beam>
+//   width <px>  height <px>     optional: spp <n>, format png|ppm|raw,
+//   camera-pos x,y,z            priority <n> (higher runs first),
+//   camera-look x,y,z           max-depth <n>, roulette <bounce>,
+//                               min-contribution <weight>;
+//                               all other fields optional too
+//
+// Replies are "ok <id> <bytes>\n" followed by the encoded image, or
+// "error <id> <message>\n". Requests on one connection are answered in the
+// order they finish, so a client may pipeline several.
+//
+// Scene paths are relative to sceneRoot; absolute paths, ".." components and
+// symlinks leading out of it are rejected, so clients can only read scenes
+// the operator put there.
+int run_server(const std::string& address, int threads, const std::string& sceneRoot);
@@ -0,0 +1,156 @@
+#include "WatchMode.h"
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "../cpu/RayTracer.h"
+#include "../image/ImageSaver.h"
+#include "../loader/FileWatcher.h"
+
+// Nearest-neighbour upscale so every preview pass has the final size
+static std::vector<Vec3> upscale(const std::vector<Vec3>& src, int sw, int sh, int dw, int dh) {
+    std::vector<Vec3> dst(size_t(dw) * dh);
+    for (int y = 0; y < dh; ++y) {
+        int sy = std::min(sh - 1, y * sh / dh);
+        for (int x = 0; x < dw; ++x) {
+            int sx = std::min(sw - 1, x * sw / dw);
+            dst[size_t(y) * dw + x] = src[size_t(sy) * sw + sx];
+        }
+    }
+    return dst;
+}
+
+static std::string describe_change(unsigned change) {
+    std::string parts;
+    if (change & SCENE_CAMERA) parts += " camera";
+    if (change & SCENE_LIGHTS) parts += " lights";
+    if (change & SCENE_MATERIALS) parts += " materials";
+    if (change & SCENE_GEOMETRY) parts += " geometry";
+    return parts;
+}
+
+int run_watch(const std::string& scene_file, int width, int height,
+              const std::string& output_file, const CameraOverride& camera, const WatchOptions& options) {
+    FileWatcher watcher(scene_file);
+
+    // The watcher thread flags changes; renders poll the same flag so a new
+    // save interrupts the pass in flight instead of waiting for it. It is
+    // joined on every way out of this function, so it never outlives the
+    // watcher and flags it uses.
+    std::atomic<bool> changed{true};
+    std::atomic<bool> stop{false};
+    std::thread poller([&watcher, &changed, &stop] {
+        while (!stop) {
+            if (watcher.wait(500)) changed = true;
+        }
+    });
+    struct Join {
+        std::atomic<bool>& stop;
+        std::thread& thread;
+        ~Join() {
+            stop = true;
+            thread.join();
+        }
+    } join{stop, poller};
+
+    std::cout << "Watching " << scene_file << " (Ctrl+C to stop), previews go to " << output_file << "\n";
+
+    Scene current;
+    bool have_scene = false;
+    auto configure = [&](RayTracer& tracer) {
+        tracer.setThreadPool(options.pool);
+        tracer.setSamplesPerPixel(options.samplesPerPixel);
+        tracer.setSeed(options.seed);
+        tracer.setSampler(options.sampler);
+        tracer.setRoulette(options.rouletteBounce);
+        tracer.setMinContribution(options.minContribution);
+        tracer.setCancelFlag(&changed);
+    };
+    RayTracer full(width, height, options.maxDepth);
+    configure(full);
+    GBuffer gbuffer;
+    bool gbuffer_valid = false;
+    // Changes not yet in a finished frame; a cancelled render leaves them
+    // pending, so the next reload redoes them even if the file is the same
+    unsigned pending = 0;
+    bool missing = false;
+
+    for (;;) {
+        if (!changed.exchange(false)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            continue;
+        }
+
+        // Editors that save by rename briefly leave no file; that is not an
+        // empty scene, so wait for it to come back
+        std::ifstream file(scene_file);
+        if (!file) {
+            if (!missing) std::cout << "[watch] " << scene_file << " is missing, waiting for it.\n";
+            missing = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            changed = true;
+            continue;
+        }
+        missing = false;
+
+        Scene next;
+        try {
+            next = load_scene_from_stream(file);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Failed to parse " << scene_file << ": " << e.what() << "\n";
+            continue;
+        }
+        camera.apply(next);
+
+        unsigned change = have_scene ? diff_scenes(current, next)
+                                     : (SCENE_CAMERA | SCENE_LIGHTS | SCENE_MATERIALS | SCENE_GEOMETRY);
+        change |= pending;
+        if (change == SCENE_UNCHANGED) {
+            std::cout << "[watch] No scene changes.\n";
+            continue;
+        }
+        current = std::move(next);
+        have_scene = true;
+        pending = change;
+        std::cout << "\n[watch] Changed:" << describe_change(change) << "\n";
+
+        auto start = std::chrono::steady_clock::now();
+        auto elapsed = [&start] {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::cout << std::fixed << std::setprecision(3);
+
+        // Shading-only edits keep primary visibility, so reshade the cached hits
+        if (!(change & (SCENE_CAMERA | SCENE_GEOMETRY)) && gbuffer_valid) {
+            full.relight(current, gbuffer);
+            if (changed) continue;
+            save_image(output_file, full.getFramebuffer(), width, height);
+            pending = SCENE_UNCHANGED;
+            std::cout << "[watch] Relit full frame in " << elapsed() << " sec\n";
+            continue;
+        }
+
+        gbuffer_valid = false;
+        for (int scale : {8, 4, 2}) {
+            int w = std::max(1, width / scale), h = std::max(1, height / scale);
+            RayTracer preview(w, h, options.maxDepth);
+            configure(preview);
+            preview.render(current);
+            if (changed) break;
+            save_image(output_file, upscale(preview.getFramebuffer(), w, h, width, height), width, height);
+            std::cout << "[watch] Preview " << w << "x" << h << " at " << elapsed() << " sec\n";
+        }
+        if (changed) continue;
+
+        // The full-resolution pass also records the G-buffer for later relights
+        full.renderGBuffer(current, gbuffer);
+        if (changed) continue;
+        gbuffer_valid = true;
+        save_image(output_file, full.getFramebuffer(), width, height);
+        pending = SCENE_UNCHANGED;
+        std::cout << "[watch] Full " << width << "x" << height << " at " << elapsed() << " sec\n";
+    }
+}
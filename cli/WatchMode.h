@@ -0,0 +1,26 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "../loader/SceneLoader.h"
+#include "../cpu/Sampler.h"
+
+class ThreadPool;
+
+// Tracer settings the previews and full-resolution renders share
+struct WatchOptions {
+    ThreadPool* pool = nullptr;   // nullptr renders on the calling thread
+    int samplesPerPixel = 1;
+    uint32_t seed = 0;
+    SamplerType sampler = SamplerType::Stratified;
+    int maxDepth = 4;
+    int rouletteBounce = 3;
+    float minContribution = 0.001f;
+};
+
+// --watch: re-renders the scene every time the file is saved. Each change
+// restarts a progressive sequence of preview passes (1/8, 1/4, 1/2, full
+// resolution), all written to the same output image. Edits that only touch
+// lights or materials are reshaded from the last full-resolution G-buffer.
+// Runs until the process is interrupted.
+int run_watch(const std::string& scene_file, int width, int height,
+              const std::string& output_file, const CameraOverride& camera, const WatchOptions& options);
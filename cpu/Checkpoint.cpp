@@ -0,0 +1,204 @@
+#include "Checkpoint.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+static const char CHECKPOINT_MAGIC[4] = {'B', 'L', 'C', 'K'};
+static const uint32_t CHECKPOINT_VERSION = 3;
+// Optional trailing section holding the AovBuffer of a --denoise/--aovs render
+static const char AOV_SECTION[4] = {'A', 'O', 'V', 'S'};
+
+template <typename T>
+static void write_raw(std::ostream& os, const T& v) {
+    os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+static bool read_raw(std::istream& is, T& v) {
+    return bool(is.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+// Bytes between the read position and the end of the file; header sizes are
+// checked against it before any buffer is sized from them
+static uint64_t remaining_bytes(std::istream& is) {
+    std::streampos at = is.tellg();
+    is.seekg(0, std::ios::end);
+    std::streampos end = is.tellg();
+    is.seekg(at);
+    return at >= 0 && end > at ? uint64_t(end - at) : 0;
+}
+
+void AccumulationBuffer::reset(int w, int h) {
+    width = w;
+    height = h;
+    sum.assign(size_t(w) * h, Vec3());
+    samples.assign(size_t(w) * h, 0);
+}
+
+void AccumulationBuffer::clear(const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        for (int x = tile.x0; x < tile.x1; ++x) {
+            sum[size_t(y) * width + x] = Vec3();
+            samples[size_t(y) * width + x] = 0;
+        }
+    }
+}
+
+uint32_t AccumulationBuffer::minSamples() const {
+    if (samples.empty()) return 0;
+    return *std::min_element(samples.begin(), samples.end());
+}
+
+uint32_t AccumulationBuffer::minSamples(const Tile& tile) const {
+    if (tile.area() <= 0) return 0;
+    uint32_t n = UINT32_MAX;
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        const uint32_t* row = &samples[size_t(y) * width];
+        n = std::min(n, *std::min_element(row + tile.x0, row + tile.x1));
+    }
+    return n;
+}
+
+uint64_t AccumulationBuffer::totalSamples() const {
+    uint64_t total = 0;
+    for (uint32_t n : samples) total += n;
+    return total;
+}
+
+void AccumulationBuffer::resolve(std::vector<Vec3>& framebuffer) const {
+    framebuffer.resize(sum.size());
+    for (size_t i = 0; i < sum.size(); ++i) {
+        framebuffer[i] = samples[i] ? sum[i] / float(samples[i]) : Vec3(0, 0, 0);
+    }
+}
+
+void AccumulationBuffer::resolve(std::vector<Vec3>& framebuffer, const Tile& tile) const {
+    framebuffer.resize(sum.size());
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        for (int x = tile.x0; x < tile.x1; ++x) {
+            size_t i = size_t(y) * width + x;
+            framebuffer[i] = samples[i] ? sum[i] / float(samples[i]) : Vec3(0, 0, 0);
+        }
+    }
+}
+
+bool RenderCheckpoint::save(const std::string& filename) const {
+    // Write to a temporary and rename, so a kill mid-write never leaves a
+    // truncated checkpoint in place of the previous good one
+    std::string tmp = filename + ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::binary);
+        if (!ofs) {
+            std::cerr << "[ERROR] Couldn't open file: " << tmp << "\n";
+            return false;
+        }
+
+        ofs.write(CHECKPOINT_MAGIC, 4);
+        write_raw(ofs, CHECKPOINT_VERSION);
+        write_raw(ofs, int32_t(accumulation.width));
+        write_raw(ofs, int32_t(accumulation.height));
+        write_raw(ofs, sceneKey);
+        write_raw(ofs, targetSamples);
+        write_raw(ofs, seed);
+        write_raw(ofs, sampler);
+        write_raw(ofs, maxDepth);
+        write_raw(ofs, rouletteBounce);
+        write_raw(ofs, minContribution);
+        for (size_t i = 0; i < accumulation.sum.size(); ++i) {
+            write_raw(ofs, accumulation.sum[i].x);
+            write_raw(ofs, accumulation.sum[i].y);
+            write_raw(ofs, accumulation.sum[i].z);
+            write_raw(ofs, accumulation.samples[i]);
+        }
+        if (aovs.width == accumulation.width && aovs.height == accumulation.height) {
+            ofs.write(AOV_SECTION, 4);
+            for (size_t i = 0; i < aovs.samples.size(); ++i) {
+                for (const Vec3* v : {&aovs.albedo[i], &aovs.normal[i]}) {
+                    write_raw(ofs, v->x);
+                    write_raw(ofs, v->y);
+                    write_raw(ofs, v->z);
+                }
+                write_raw(ofs, aovs.depth[i]);
+                write_raw(ofs, aovs.luminance[i]);
+                write_raw(ofs, aovs.luminanceSq[i]);
+                write_raw(ofs, aovs.samples[i]);
+                write_raw(ofs, aovs.colorSamples[i]);
+            }
+        }
+        if (!ofs) {
+            std::cerr << "[ERROR] Failed to write checkpoint: " << tmp << "\n";
+            return false;
+        }
+    }
+    std::remove(filename.c_str());
+    if (std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        std::cerr << "[ERROR] Failed to move checkpoint into place: " << filename << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool RenderCheckpoint::load(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) {
+        std::cerr << "[ERROR] Couldn't open checkpoint: " << filename << "\n";
+        return false;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t w = 0, h = 0;
+    if (!ifs.read(magic, 4) || std::string(magic, 4) != std::string(CHECKPOINT_MAGIC, 4) ||
+        !read_raw(ifs, version) || version != CHECKPOINT_VERSION ||
+        !read_raw(ifs, w) || !read_raw(ifs, h) || w <= 0 || h <= 0 ||
+        !read_raw(ifs, sceneKey) || !read_raw(ifs, targetSamples) || !read_raw(ifs, seed) ||
+        !read_raw(ifs, sampler) || !read_raw(ifs, maxDepth) || !read_raw(ifs, rouletteBounce) ||
+        !read_raw(ifs, minContribution)) {
+        std::cerr << "[ERROR] Not a valid checkpoint file: " << filename << "\n";
+        return false;
+    }
+
+    // sum and sample count of every pixel
+    uint64_t pixels = uint64_t(w) * uint64_t(h);
+    if (pixels > remaining_bytes(ifs) / (4 * 4)) {
+        std::cerr << "[ERROR] Truncated checkpoint file: " << filename << "\n";
+        return false;
+    }
+    accumulation.reset(w, h);
+    for (size_t i = 0; i < accumulation.sum.size(); ++i) {
+        Vec3& s = accumulation.sum[i];
+        if (!read_raw(ifs, s.x) || !read_raw(ifs, s.y) || !read_raw(ifs, s.z) ||
+            !read_raw(ifs, accumulation.samples[i])) {
+            std::cerr << "[ERROR] Truncated checkpoint file: " << filename << "\n";
+            return false;
+        }
+    }
+
+    aovs = AovBuffer();
+    char section[4];
+    if (!ifs.read(section, 4)) return true;
+    if (std::string(section, 4) != std::string(AOV_SECTION, 4)) {
+        std::cerr << "[ERROR] Not a valid checkpoint file: " << filename << "\n";
+        return false;
+    }
+    // albedo, normal, depth, luminance moments and both sample counts
+    if (pixels > remaining_bytes(ifs) / (11 * 4)) {
+        std::cerr << "[ERROR] Truncated checkpoint file: " << filename << "\n";
+        return false;
+    }
+    aovs.reset(w, h);
+    for (size_t i = 0; i < aovs.samples.size(); ++i) {
+        bool ok = true;
+        for (Vec3* v : {&aovs.albedo[i], &aovs.normal[i]}) {
+            ok = ok && read_raw(ifs, v->x) && read_raw(ifs, v->y) && read_raw(ifs, v->z);
+        }
+        if (!ok || !read_raw(ifs, aovs.depth[i]) || !read_raw(ifs, aovs.luminance[i]) ||
+            !read_raw(ifs, aovs.luminanceSq[i]) || !read_raw(ifs, aovs.samples[i]) ||
+            !read_raw(ifs, aovs.colorSamples[i])) {
+            std::cerr << "[ERROR] Truncated checkpoint file: " << filename << "\n";
+            return false;
+        }
+    }
+    return true;
+}
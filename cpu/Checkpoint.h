@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Vec3.h"
+#include "Tile.h"
+#include "Denoiser.h"
+
+// Per-pixel running sums for multi-sample renders.
+struct AccumulationBuffer {
+    int width = 0, height = 0;
+    std::vector<Vec3> sum;
+    std::vector<uint32_t> samples;
+
+    void reset(int w, int h);
+    void clear(const Tile& tile);
+    uint32_t minSamples() const;
+    uint32_t minSamples(const Tile& tile) const;
+    uint64_t totalSamples() const;
+    // Average into framebuffer; pixels without samples come out black.
+    void resolve(std::vector<Vec3>& framebuffer) const;
+    void resolve(std::vector<Vec3>& framebuffer, const Tile& tile) const;
+};
+
+// Everything needed to continue an interrupted render bit-exactly. Sample
+// positions are a pure function of (sampler, pixel, sample index, seed), so
+// the per-pixel sample counts double as the sampler state.
+struct RenderCheckpoint {
+    uint64_t sceneKey = 0;        // scene_hash of the scene being rendered
+    uint32_t targetSamples = 1;
+    uint32_t seed = 0;
+    uint32_t sampler = 1;         // SamplerType
+    // Path termination settings; samples made with others estimate a different image
+    int32_t maxDepth = 4;
+    int32_t rouletteBounce = 3;
+    float minContribution = 0.001f;
+    AccumulationBuffer accumulation;
+    AovBuffer aovs;               // width 0 when the render kept none
+
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+};
@@ -0,0 +1,80 @@
+#include "CostMap.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include "../Vec3.h"
+#include "../image/ImageSaver.h"
+
+void CostMap::reset(int w, int h) {
+    width = w;
+    height = h;
+    nanoseconds.assign(size_t(w) * h, 0.0f);
+    tests.assign(size_t(w) * h, 0.0f);
+    rays.assign(size_t(w) * h, 0.0f);
+}
+
+double CostMap::tileNanoseconds(const Tile& tile) const {
+    double sum = 0.0;
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        for (int x = tile.x0; x < tile.x1; ++x) sum += nanoseconds[size_t(y) * width + x];
+    }
+    return sum;
+}
+
+float CostMap::maxNanoseconds() const {
+    return nanoseconds.empty() ? 0.0f : *std::max_element(nanoseconds.begin(), nanoseconds.end());
+}
+
+// Black -> blue -> magenta -> orange -> yellow -> white
+static Vec3 heat_color(float t) {
+    static const Vec3 stops[] = {
+        Vec3(0.0f, 0.0f, 0.0f), Vec3(0.1f, 0.1f, 0.6f), Vec3(0.7f, 0.1f, 0.6f),
+        Vec3(1.0f, 0.5f, 0.0f), Vec3(1.0f, 0.95f, 0.2f), Vec3(1.0f, 1.0f, 1.0f),
+    };
+    const int segments = int(sizeof(stops) / sizeof(stops[0])) - 1;
+    float s = std::clamp(t, 0.0f, 1.0f) * segments;
+    int i = std::min(int(s), segments - 1);
+    float f = s - i;
+    return stops[i] * (1.0f - f) + stops[i + 1] * f;
+}
+
+bool CostMap::saveHeatmap(const std::string& filename, const std::string& metric) const {
+    const std::vector<float>& values = metric == "tests" ? tests : metric == "rays" ? rays : nanoseconds;
+    if (values.empty()) return false;
+    std::vector<float> sorted(values);
+    size_t p99 = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+    std::nth_element(sorted.begin(), sorted.begin() + p99, sorted.end());
+    float scale = sorted[p99] > 0.0f ? 1.0f / sorted[p99] : 0.0f;
+
+    std::vector<Vec3> image(values.size());
+    for (size_t i = 0; i < image.size(); ++i) image[i] = heat_color(values[i] * scale);
+    return save_image(filename, image, width, height);
+}
+
+bool CostMap::savePFM(const std::string& filename) const {
+    FILE* f = std::fopen(filename.c_str(), "wb");
+    if (!f) {
+        std::cerr << "[ERROR] Couldn't open file: " << filename << "\n";
+        return false;
+    }
+    // Native floats; the sign of the scale records the byte order
+    const uint16_t probe = 1;
+    bool little_endian = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+    std::fprintf(f, "PF\n%d %d\n%s\n", width, height, little_endian ? "-1.0" : "1.0");
+    // PFM stores rows bottom-up
+    std::vector<float> row(size_t(width) * 3);
+    bool ok = true;
+    for (int y = height - 1; y >= 0 && ok; --y) {
+        for (int x = 0; x < width; ++x) {
+            size_t i = size_t(y) * width + x;
+            row[3 * x + 0] = nanoseconds[i];
+            row[3 * x + 1] = tests[i];
+            row[3 * x + 2] = rays[i];
+        }
+        ok = std::fwrite(row.data(), sizeof(float), row.size(), f) == row.size();
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (ok) std::cout << "[OK] Saved cost data: " << filename << "\n";
+    else std::cerr << "[ERROR] Failed to write cost data: " << filename << "\n";
+    return ok;
+}
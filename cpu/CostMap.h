@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Tile.h"
+
+// Per-pixel render cost, summed over all samples of a render.
+struct CostMap {
+    int width = 0, height = 0;
+    std::vector<float> nanoseconds;
+    std::vector<float> tests;   // primitive intersection tests
+    std::vector<float> rays;    // primary + shadow + reflection
+
+    void reset(int w, int h);
+    double tileNanoseconds(const Tile& tile) const;
+    float maxNanoseconds() const;
+
+    // False-colour PNG/PPM of one channel ("time", "tests" or "rays"), scaled
+    // to the 99th percentile so a few outliers don't wash out the rest.
+    // Time is the most direct measure but picks up scheduling noise; the
+    // counts are deterministic.
+    bool saveHeatmap(const std::string& filename, const std::string& metric = "time") const;
+    // Three-channel PFM with ns, tests and rays per pixel.
+    bool savePFM(const std::string& filename) const;
+};
@@ -0,0 +1,223 @@
+#include "Denoiser.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include "Trace.h"
+#include "../image/ImageSaver.h"
+
+static const float SIGMA_LUMINANCE = 4.0f;
+static const int NORMAL_POWER_LOG2 = 7;    // normal weight is dot(n_p, n_q)^128
+static const float SIGMA_DEPTH = 1.0f;
+static const float SIGMA_ALBEDO = 0.1f;
+static const int ROWS_PER_TASK = 16;
+
+static float luminance(const Vec3& c) {
+    return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+}
+
+void AovBuffer::reset(int w, int h) {
+    width = w;
+    height = h;
+    size_t n = size_t(w) * h;
+    albedo.assign(n, Vec3());
+    normal.assign(n, Vec3());
+    depth.assign(n, 0.0f);
+    luminance.assign(n, 0.0f);
+    luminanceSq.assign(n, 0.0f);
+    samples.assign(n, 0);
+    colorSamples.assign(n, 0);
+}
+
+void AovBuffer::add(size_t i, const Vec3& sampleAlbedo, const Vec3& sampleNormal, float sampleDepth,
+                    const Vec3& color) {
+    addGeometry(i, sampleAlbedo, sampleNormal, sampleDepth);
+    float l = ::luminance(color);
+    luminance[i] += l;
+    luminanceSq[i] += l * l;
+    ++colorSamples[i];
+}
+
+void AovBuffer::addGeometry(size_t i, const Vec3& sampleAlbedo, const Vec3& sampleNormal, float sampleDepth) {
+    albedo[i] += sampleAlbedo;
+    normal[i] += sampleNormal;
+    depth[i] += sampleDepth;
+    ++samples[i];
+}
+
+bool AovBuffer::save(const std::string& prefix) const {
+    size_t n = size_t(width) * height;
+    std::vector<Vec3> albedoImage(n), normalImage(n), depthImage(n);
+    float maxDepth = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        if (samples[i]) maxDepth = std::max(maxDepth, depth[i] / samples[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!samples[i]) continue;
+        float inv = 1.0f / samples[i];
+        albedoImage[i] = albedo[i] * inv;
+        normalImage[i] = normal[i] * (0.5f * inv) + Vec3(0.5f, 0.5f, 0.5f);
+        float d = depth[i] * inv;
+        float shade = d > 0.0f && maxDepth > 0.0f ? 1.0f - 0.9f * d / maxDepth : 0.0f;
+        depthImage[i] = Vec3(shade, shade, shade);
+    }
+    bool ok = save_image(prefix + "_albedo.png", albedoImage, width, height);
+    ok = save_image(prefix + "_normal.png", normalImage, width, height) && ok;
+    ok = save_image(prefix + "_depth.png", depthImage, width, height) && ok;
+    if (ok) std::cout << "[OK] Saved AOVs: " << prefix << "_{albedo,normal,depth}.png\n";
+    return ok;
+}
+
+// Runs body(y0, y1) over bands of rows, on the pool when there is one
+static void for_rows(int height, ThreadPool* pool, const std::function<void(int, int)>& body) {
+    if (!pool) {
+        body(0, height);
+        return;
+    }
+    TaskGroup group(*pool);
+    for (int y = 0; y < height; y += ROWS_PER_TASK) {
+        group.run([&body, y, height] { body(y, std::min(y + ROWS_PER_TASK, height)); });
+    }
+    group.wait();
+}
+
+void denoise(const std::vector<Vec3>& color, const AovBuffer& aovs, std::vector<Vec3>& out, ThreadPool* pool,
+             int iterations) {
+    TRACE_SCOPE("image", "denoise");
+    const int width = aovs.width, height = aovs.height;
+    const size_t n = size_t(width) * height;
+
+    // Per-pixel means of the guides and the variance of the color estimate
+    std::vector<Vec3> albedo(n), normal(n);
+    std::vector<float> depth(n, 0.0f), variance(n, 0.0f);
+    for (size_t i = 0; i < n; ++i) {
+        uint32_t s = aovs.samples[i];
+        if (!s) continue;
+        float inv = 1.0f / s;
+        albedo[i] = aovs.albedo[i] * inv;
+        normal[i] = aovs.normal[i] * inv;
+        depth[i] = aovs.depth[i] * inv;
+        uint32_t c = aovs.colorSamples[i];
+        if (c > 1) {
+            float invColor = 1.0f / c;
+            float mean = aovs.luminance[i] * invColor;
+            float sampleVariance = std::max(0.0f, aovs.luminanceSq[i] * invColor - mean * mean) * c / (c - 1);
+            variance[i] = sampleVariance * invColor;
+        }
+    }
+
+    // Too few samples to trust the per-pixel moments: use the luminance
+    // spread of the 3x3 neighbourhood instead
+    for_rows(height, pool, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            for (int x = 0; x < width; ++x) {
+                size_t i = size_t(y) * width + x;
+                if (aovs.colorSamples[i] >= 4) continue;
+                float sum = 0.0f, sumSq = 0.0f;
+                int count = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int qx = x + dx, qy = y + dy;
+                        if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                        float l = luminance(color[size_t(qy) * width + qx]);
+                        sum += l;
+                        sumSq += l * l;
+                        ++count;
+                    }
+                }
+                float mean = sum / count;
+                variance[i] = std::max(variance[i], std::max(0.0f, sumSq / count - mean * mean));
+            }
+        }
+    });
+
+    // Depth change per pixel, so slanted surfaces are not mistaken for edges
+    std::vector<float> depthSlope(n, 0.0f);
+    auto depthAt = [&](int x, int y, float fallback) {
+        if (x < 0 || y < 0 || x >= width || y >= height) return fallback;
+        float d = depth[size_t(y) * width + x];
+        return d > 0.0f ? d : fallback;
+    };
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            float d = depth[size_t(y) * width + x];
+            if (d <= 0.0f) continue;
+            float dx = 0.5f * std::fabs(depthAt(x + 1, y, d) - depthAt(x - 1, y, d));
+            float dy = 0.5f * std::fabs(depthAt(x, y + 1, d) - depthAt(x, y - 1, d));
+            depthSlope[size_t(y) * width + x] = std::max(dx, dy);
+        }
+    }
+
+    static const float kernel[3] = {3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f};
+    std::vector<Vec3> current(color), next(n);
+    std::vector<float> nextVariance(n), blurred(n);
+
+    for (int pass = 0; pass < iterations; ++pass) {
+        const int step = 1 << pass;
+
+        // 3x3 Gaussian of the variance steadies the luminance weight
+        for_rows(height, pool, [&](int y0, int y1) {
+            for (int y = y0; y < y1; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    float sum = 0.0f, weights = 0.0f;
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            int qx = x + dx, qy = y + dy;
+                            if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                            float w = (dx ? 0.5f : 1.0f) * (dy ? 0.5f : 1.0f);
+                            sum += variance[size_t(qy) * width + qx] * w;
+                            weights += w;
+                        }
+                    }
+                    blurred[size_t(y) * width + x] = sum / weights;
+                }
+            }
+        });
+
+        for_rows(height, pool, [&](int y0, int y1) {
+            for (int y = y0; y < y1; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    size_t p = size_t(y) * width + x;
+                    float lp = luminance(current[p]);
+                    float phiLuminance = SIGMA_LUMINANCE * std::sqrt(blurred[p]) + 1e-4f;
+                    bool hitP = depth[p] > 0.0f;
+
+                    Vec3 sum;
+                    float weights = 0.0f, varianceSum = 0.0f;
+                    for (int dy = -2; dy <= 2; ++dy) {
+                        for (int dx = -2; dx <= 2; ++dx) {
+                            int qx = x + dx * step, qy = y + dy * step;
+                            if (qx < 0 || qy < 0 || qx >= width || qy >= height) continue;
+                            size_t q = size_t(qy) * width + qx;
+                            if (hitP != (depth[q] > 0.0f)) continue;
+
+                            float w = kernel[std::abs(dx)] * kernel[std::abs(dy)];
+                            if (q != p) {
+                                Vec3 da = albedo[p] - albedo[q];
+                                float exponent = std::fabs(lp - luminance(current[q])) / phiLuminance +
+                                                 da.dot(da) / (SIGMA_ALBEDO * SIGMA_ALBEDO);
+                                if (hitP) {
+                                    float distance = step * std::sqrt(float(dx * dx + dy * dy));
+                                    float phiDepth = SIGMA_DEPTH * depthSlope[p] * distance + 1e-3f * depth[p];
+                                    exponent += std::fabs(depth[p] - depth[q]) / phiDepth;
+                                    float cosine = std::max(0.0f, normal[p].dot(normal[q]));
+                                    for (int k = 0; k < NORMAL_POWER_LOG2; ++k) cosine *= cosine;
+                                    w *= cosine;
+                                }
+                                w *= std::exp(-exponent);
+                            }
+                            sum += current[q] * w;
+                            weights += w;
+                            varianceSum += w * w * variance[q];
+                        }
+                    }
+                    next[p] = sum / weights;
+                    nextVariance[p] = varianceSum / (weights * weights);
+                }
+            }
+        });
+        current.swap(next);
+        variance.swap(nextVariance);
+    }
+    out.swap(current);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Vec3.h"
+#include "ThreadPool.h"
+
+// Auxiliary buffers of the primary hits, averaged over all samples of a
+// render, plus the luminance moments of the color samples. Misses record
+// zero normal and depth. Samples restored from a checkpoint without AOVs
+// come back as geometry only, so the moments may cover fewer samples.
+struct AovBuffer {
+    int width = 0, height = 0;
+    std::vector<Vec3> albedo;
+    std::vector<Vec3> normal;
+    std::vector<float> depth;          // distance from the camera
+    std::vector<float> luminance;      // per-sample sum and sum of squares
+    std::vector<float> luminanceSq;
+    std::vector<uint32_t> samples;
+    std::vector<uint32_t> colorSamples;  // samples in the luminance moments
+
+    void reset(int w, int h);
+    void add(size_t index, const Vec3& sampleAlbedo, const Vec3& sampleNormal, float sampleDepth, const Vec3& color);
+    void addGeometry(size_t index, const Vec3& sampleAlbedo, const Vec3& sampleNormal, float sampleDepth);
+
+    // <prefix>_albedo.png, <prefix>_normal.png (mapped to [0, 1]) and
+    // <prefix>_depth.png (nearest white, misses black); false if any failed.
+    bool save(const std::string& prefix) const;
+};
+
+// Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010). Each pass is
+// a 5x5 B3-spline kernel with holes, twice as wide as the last. Its weights
+// fall off with normal, depth and albedo differences, and with luminance
+// differences relative to the estimated noise (variance-guided, as in SVGF).
+// Rows are split over the pool; the result does not depend on thread count.
+void denoise(const std::vector<Vec3>& color, const AovBuffer& aovs, std::vector<Vec3>& out,
+             ThreadPool* pool = nullptr, int iterations = 5);
@@ -0,0 +1,179 @@
+#include "Emitters.h"
+#include "Intersect.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+
+static const float PI = 3.14159265358979f;
+
+static float luminance(const Vec3& c) {
+    return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+}
+
+static float component(const Vec3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static void set_component(Vec3& v, int axis, float value) {
+    if (axis == 0) v.x = value;
+    else if (axis == 1) v.y = value;
+    else v.z = value;
+}
+
+// Orthonormal tangents of a unit vector (Duff et al. 2017)
+static void tangent_frame(const Vec3& n, Vec3& t1, Vec3& t2) {
+    float sign = std::copysign(1.0f, n.z);
+    float a = -1.0f / (sign + n.z);
+    float b = n.x * n.y * a;
+    t1 = Vec3(1.0f + sign * n.x * n.x * a, sign * b, -sign * n.x);
+    t2 = Vec3(b, sign + n.y * n.y * a, -n.y);
+}
+
+static float cube_area(const Cube& c) {
+    Vec3 d = c.max - c.min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+// 1 - cos of the half-angle of the cone a sphere covers from p; 0 from inside
+static float sphere_cone(const Sphere& s, const Vec3& p) {
+    Vec3 d = s.center - p;
+    float dist2 = d.dot(d), r2 = s.radius * s.radius;
+    if (dist2 <= r2) return 0.0f;
+    return 1.0f - std::sqrt(std::max(0.0f, 1.0f - r2 / dist2));
+}
+
+void EmitterList::build(const Scene& scene) {
+    TRACE_SCOPE("render", "build_emitters");
+    emitters.clear();
+    cdf.clear();
+    emitterOfPrimitive.clear();
+
+    std::vector<float> power;
+    auto add = [&](Shape shape, int index, int primitiveId, float area, const Material& mat) {
+        float p = luminance(mat.emission) * area;
+        if (!(p > 0.0f)) return;
+        emitters.push_back({shape, index, primitiveId, area, 0.0f});
+        power.push_back(p);
+    };
+
+    int id = 0;
+    for (size_t i = 0; i < scene.spheres.size(); ++i, ++id) {
+        const Sphere& s = scene.spheres[i];
+        add(Shape::Sphere, int(i), id, 4.0f * PI * s.radius * s.radius, s.material);
+    }
+    id += int(scene.planes.size());
+    for (size_t i = 0; i < scene.cubes.size(); ++i, ++id) {
+        add(Shape::Cube, int(i), id, cube_area(scene.cubes[i]), scene.cubes[i].material);
+    }
+    for (size_t i = 0; i < scene.triangles.size(); ++i, ++id) {
+        const Triangle& t = scene.triangles[i];
+        add(Shape::Triangle, int(i), id, 0.5f * (t.v1 - t.v0).cross(t.v2 - t.v0).length(), t.material);
+    }
+    if (emitters.empty()) return;
+
+    double total = 0.0;
+    for (float p : power) total += p;
+    double running = 0.0;
+    cdf.push_back(0.0f);
+    emitterOfPrimitive.assign(size_t(id), -1);
+    for (size_t i = 0; i < emitters.size(); ++i) {
+        emitters[i].probability = float(power[i] / total);
+        running += power[i];
+        cdf.push_back(float(running / total));
+        emitterOfPrimitive[emitters[i].primitiveId] = int(i);
+    }
+    cdf.back() = 1.0f;
+}
+
+bool EmitterList::sample(const Scene& scene, const Vec3& p, float u, float v, float w, EmitterSample& out) const {
+    if (emitters.empty()) return false;
+    size_t i = size_t(std::upper_bound(cdf.begin() + 1, cdf.end(), u) - (cdf.begin() + 1));
+    const Emitter& e = emitters[std::min(i, emitters.size() - 1)];
+    out.primitiveId = e.primitiveId;
+
+    if (e.shape == Shape::Sphere) {
+        const Sphere& s = scene.spheres[e.index];
+        float cone = sphere_cone(s, p);
+        if (!(cone > 0.0f)) return false;
+        Vec3 axis = (s.center - p).normalized(), t1, t2;
+        tangent_frame(axis, t1, t2);
+        float cosTheta = 1.0f - v * cone;
+        float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+        float phi = 2.0f * PI * w;
+        out.direction = (t1 * std::cos(phi) + t2 * std::sin(phi)) * sinTheta + axis * cosTheta;
+        Vec3 hit, normal;
+        if (!intersect_sphere(Ray(p, out.direction), s, out.distance, hit, normal)) return false;
+        out.pdf = e.probability / (2.0f * PI * cone);
+        out.emission = s.material.emission;
+        return true;
+    }
+
+    Vec3 point, normal;
+    if (e.shape == Shape::Triangle) {
+        const Triangle& t = scene.triangles[e.index];
+        float su = std::sqrt(v);
+        point = t.v0 * (1.0f - su) + t.v1 * (su * (1.0f - w)) + t.v2 * (su * w);
+        normal = (t.v1 - t.v0).cross(t.v2 - t.v0).normalized();
+        out.emission = t.material.emission;
+    } else {
+        // Pick one of the six faces by area, then a point on it
+        const Cube& c = scene.cubes[e.index];
+        Vec3 d = c.max - c.min;
+        float faces[3] = {d.y * d.z, d.z * d.x, d.x * d.y};
+        float s = v * e.area;
+        int axis = 2;
+        bool maxSide = true;
+        for (int a = 0; a < 3; ++a) {
+            if (s < 2.0f * faces[a]) {
+                axis = a;
+                maxSide = s >= faces[a];
+                s = (s - (maxSide ? faces[a] : 0.0f)) / faces[a];
+                break;
+            }
+            s -= 2.0f * faces[a];
+        }
+        s = std::min(std::max(s, 0.0f), 1.0f);
+        int a1 = (axis + 1) % 3, a2 = (axis + 2) % 3;
+        set_component(point, axis, component(maxSide ? c.max : c.min, axis));
+        set_component(point, a1, component(c.min, a1) + s * component(d, a1));
+        set_component(point, a2, component(c.min, a2) + w * component(d, a2));
+        set_component(normal, axis, maxSide ? 1.0f : -1.0f);
+        out.emission = c.material.emission;
+    }
+
+    Vec3 toPoint = point - p;
+    float dist2 = toPoint.dot(toPoint);
+    if (!(dist2 > 0.0f)) return false;
+    out.distance = std::sqrt(dist2);
+    out.direction = toPoint / out.distance;
+    float cosLight = std::fabs(normal.dot(out.direction));
+    if (cosLight < 1e-6f) return false;
+    out.pdf = e.probability * dist2 / (e.area * cosLight);
+    return true;
+}
+
+float EmitterList::pdf(const Scene& scene, int primitiveId, const Vec3& p, const Vec3& hit,
+                       const Vec3& lightNormal) const {
+    if (primitiveId < 0 || size_t(primitiveId) >= emitterOfPrimitive.size()) return 0.0f;
+    int i = emitterOfPrimitive[primitiveId];
+    if (i < 0) return 0.0f;
+    const Emitter& e = emitters[i];
+
+    if (e.shape == Shape::Sphere) {
+        float cone = sphere_cone(scene.spheres[e.index], p);
+        return cone > 0.0f ? e.probability / (2.0f * PI * cone) : 0.0f;
+    }
+    Vec3 toHit = hit - p;
+    float dist2 = toHit.dot(toHit);
+    if (!(dist2 > 0.0f)) return 0.0f;
+    float cosLight = std::fabs(lightNormal.dot(toHit / std::sqrt(dist2)));
+    if (cosLight < 1e-6f) return 0.0f;
+    return e.probability * dist2 / (e.area * cosLight);
+}
+
+Vec3 sample_cosine_hemisphere(const Vec3& normal, float u, float v) {
+    Vec3 t1, t2;
+    tangent_frame(normal, t1, t2);
+    float r = std::sqrt(u), phi = 2.0f * PI * v;
+    return t1 * (r * std::cos(phi)) + t2 * (r * std::sin(phi)) + normal * std::sqrt(std::max(0.0f, 1.0f - u));
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <vector>
+#include "../Vec3.h"
+#include "../loader/SceneLoader.h"
+
+// One light-sampling decision: a direction from the shading point toward an
+// emitter, the distance to the sampled surface point along it and the
+// solid-angle density of having picked it (emitter selection included).
+struct EmitterSample {
+    Vec3 direction;
+    float distance = 0.0f;
+    float pdf = 0.0f;
+    int primitiveId = -1;   // numbered as in scene_material
+    Vec3 emission;
+};
+
+// Primitives with non-zero emission, sampled as area lights. Emitters are
+// picked in proportion to their power (luminance times surface area);
+// spheres are sampled by the solid angle they cover, triangles and cubes
+// uniformly over their area. Infinite planes are not in the list; they are
+// only found by the tracer's cosine-weighted rays. Built once per render.
+class EmitterList {
+public:
+    void build(const Scene& scene);
+    bool empty() const { return emitters.empty(); }
+    size_t size() const { return emitters.size(); }
+
+    // u picks the emitter, v and w the point on it; false when the emitter
+    // cannot be seen from p (p inside a sphere, grazing angle).
+    bool sample(const Scene& scene, const Vec3& p, float u, float v, float w, EmitterSample& out) const;
+    // Density sample() has for reaching primitiveId at point hit (with
+    // surface normal lightNormal) from p; 0 for primitives that are not emitters.
+    float pdf(const Scene& scene, int primitiveId, const Vec3& p, const Vec3& hit, const Vec3& lightNormal) const;
+
+private:
+    enum class Shape { Sphere, Cube, Triangle };
+    struct Emitter {
+        Shape shape;
+        int index;         // into the scene's vector for that shape
+        int primitiveId;
+        float area;
+        float probability;
+    };
+    std::vector<Emitter> emitters;
+    std::vector<float> cdf;              // emitters.size() + 1 entries, 0 to 1
+    std::vector<int> emitterOfPrimitive; // -1 for non-emitters
+};
+
+// Cosine-weighted direction on the hemisphere around normal; density cos / pi.
+Vec3 sample_cosine_hemisphere(const Vec3& normal, float u, float v);
@@ -0,0 +1,113 @@
+#include "GBuffer.h"
+#include <fstream>
+#include <iostream>
+
+static const char GBUFFER_MAGIC[4] = {'B', 'L', 'G', 'B'};
+static const uint32_t GBUFFER_VERSION = 2;
+
+template <typename T>
+static void write_raw(std::ostream& os, const T& v) {
+    os.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <typename T>
+static bool read_raw(std::istream& is, T& v) {
+    return bool(is.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+// Bytes between the read position and the end of the file; header sizes are
+// checked against it before any buffer is sized from them
+static uint64_t remaining_bytes(std::istream& is) {
+    std::streampos at = is.tellg();
+    is.seekg(0, std::ios::end);
+    std::streampos end = is.tellg();
+    is.seekg(at);
+    return at >= 0 && end > at ? uint64_t(end - at) : 0;
+}
+
+static void write_vec3(std::ostream& os, const Vec3& v) {
+    write_raw(os, v.x);
+    write_raw(os, v.y);
+    write_raw(os, v.z);
+}
+
+static bool read_vec3(std::istream& is, Vec3& v) {
+    return read_raw(is, v.x) && read_raw(is, v.y) && read_raw(is, v.z);
+}
+
+void GBuffer::resize(int w, int h, int samplesPerPixel) {
+    width = w;
+    height = h;
+    samples = samplesPerPixel;
+    size_t entries = size_t(w) * h * samplesPerPixel;
+    position.assign(entries, Vec3());
+    normal.assign(entries, Vec3());
+    materialId.assign(entries, -1);
+}
+
+bool GBuffer::save(const std::string& filename) const {
+    std::ofstream ofs(filename, std::ios::binary);
+    if (!ofs) {
+        std::cerr << "[ERROR] Couldn't open file: " << filename << "\n";
+        return false;
+    }
+
+    ofs.write(GBUFFER_MAGIC, 4);
+    write_raw(ofs, GBUFFER_VERSION);
+    write_raw(ofs, int32_t(width));
+    write_raw(ofs, int32_t(height));
+    write_raw(ofs, int32_t(samples));
+    write_raw(ofs, sceneKey);
+    write_raw(ofs, seed);
+    write_raw(ofs, sampler);
+    for (size_t i = 0; i < materialId.size(); ++i) {
+        write_vec3(ofs, position[i]);
+        write_vec3(ofs, normal[i]);
+        write_raw(ofs, int32_t(materialId[i]));
+    }
+    return bool(ofs);
+}
+
+bool GBuffer::load(const std::string& filename) {
+    std::ifstream ifs(filename, std::ios::binary);
+    if (!ifs) return false;
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t w = 0, h = 0, n = 0;
+    if (!ifs.read(magic, 4) || std::string(magic, 4) != std::string(GBUFFER_MAGIC, 4) ||
+        !read_raw(ifs, version) || version != GBUFFER_VERSION ||
+        !read_raw(ifs, w) || !read_raw(ifs, h) || !read_raw(ifs, n) || w <= 0 || h <= 0 || n <= 0) {
+        std::cerr << "[WARNING] Not a valid G-buffer file: " << filename << "\n";
+        return false;
+    }
+
+    uint64_t key = 0;
+    uint32_t keySeed = 0, keySampler = 0;
+    if (!read_raw(ifs, key) || !read_raw(ifs, keySeed) || !read_raw(ifs, keySampler)) {
+        std::cerr << "[WARNING] Not a valid G-buffer file: " << filename << "\n";
+        return false;
+    }
+    // position, normal and material id of every sample
+    const uint64_t recordSize = 7 * 4;
+    uint64_t records = remaining_bytes(ifs) / recordSize;
+    uint64_t pixels = uint64_t(w) * uint64_t(h);
+    if (pixels > records || uint64_t(n) > records / pixels) {
+        std::cerr << "[WARNING] Truncated G-buffer file: " << filename << "\n";
+        return false;
+    }
+    resize(w, h, n);
+    sceneKey = key;
+    seed = keySeed;
+    sampler = keySampler;
+    for (size_t i = 0; i < materialId.size(); ++i) {
+        int32_t id;
+        if (!read_vec3(ifs, position[i]) || !read_vec3(ifs, normal[i]) || !read_raw(ifs, id)) {
+            std::cerr << "[WARNING] Truncated G-buffer file: " << filename << "\n";
+            resize(0, 0);
+            return false;
+        }
+        materialId[i] = id;
+    }
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Vec3.h"
+
+// Primary-hit data for one camera and geometry configuration. Lights and
+// materials can change freely; sceneKey (scene_geometry_hash) must match.
+// Each pixel holds one entry per sample, sample s of pixel i at
+// i * samples + s; with several samples their positions depend on the seed
+// and sampler, which must match as well.
+struct GBuffer {
+    int width = 0, height = 0;
+    int samples = 1;
+    uint64_t sceneKey = 0;
+    uint32_t seed = 0;
+    uint32_t sampler = 1;          // SamplerType
+    std::vector<Vec3> position;
+    std::vector<Vec3> normal;
+    std::vector<int> materialId;   // primitive id (see scene_material), -1 on miss
+
+    void resize(int w, int h, int samplesPerPixel = 1);
+    bool save(const std::string& filename) const;
+    bool load(const std::string& filename);
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include <cmath>
+#include <utility>
+#include "../Vec3.h"
+#include "../loader/SceneLoader.h"
+
+struct Ray {
+    Vec3 origin;
+    Vec3 direction;
+
+    Ray(const Vec3& o, const Vec3& d) : origin(o), direction(d.normalized()) {}
+};
+
+// Ray-primitive kernels. Each reports the nearest hit in front of the ray
+// origin as distance t, hit point and surface normal. Header-only so they
+// inline into the tracer's loops and can be benchmarked in isolation.
+
+inline bool intersect_sphere(const Ray& ray, const Sphere& s, float& t, Vec3& hit, Vec3& normal) {
+    Vec3 oc = ray.origin - s.center;
+    float b = 2.0f * oc.dot(ray.direction);
+    float c = oc.dot(oc) - s.radius * s.radius;
+    float disc = b * b - 4 * c;
+
+    if (disc < 0) return false;
+
+    float sqrtDisc = std::sqrt(disc);
+    float t0 = (-b - sqrtDisc) * 0.5f;
+    float t1 = (-b + sqrtDisc) * 0.5f;
+    t = (t0 > 0) ? t0 : t1;
+
+    if (t <= 0) return false;
+
+    hit = ray.origin + ray.direction * t;
+    normal = (hit - s.center).normalized();
+    return true;
+}
+
+inline bool intersect_plane(const Ray& ray, const Plane& p, float& t, Vec3& hit, Vec3& normalOut) {
+    float denom = p.normal.dot(ray.direction);
+    if (std::fabs(denom) < 1e-6) return false;
+
+    float tHit = (p.point - ray.origin).dot(p.normal) / denom;
+    if (tHit < 0) return false;
+
+    t = tHit;
+    hit = ray.origin + ray.direction * t;
+    normalOut = p.normal;
+    return true;
+}
+
+// Ray-AABB (cube) intersection
+inline bool intersect_cube(const Ray& ray, const Cube& cube, float& t, Vec3& hit, Vec3& normal) {
+    float tmin = (cube.min.x - ray.origin.x) / ray.direction.x;
+    float tmax = (cube.max.x - ray.origin.x) / ray.direction.x;
+    if (tmin > tmax) std::swap(tmin, tmax);
+
+    float tymin = (cube.min.y - ray.origin.y) / ray.direction.y;
+    float tymax = (cube.max.y - ray.origin.y) / ray.direction.y;
+    if (tymin > tymax) std::swap(tymin, tymax);
+
+    if ((tmin > tymax) || (tymin > tmax))
+        return false;
+
+    if (tymin > tmin) tmin = tymin;
+    if (tymax < tmax) tmax = tymax;
+
+    float tzmin = (cube.min.z - ray.origin.z) / ray.direction.z;
+    float tzmax = (cube.max.z - ray.origin.z) / ray.direction.z;
+    if (tzmin > tzmax) std::swap(tzmin, tzmax);
+
+    if ((tmin > tzmax) || (tzmin > tmax))
+        return false;
+
+    if (tzmin > tmin) tmin = tzmin;
+    if (tzmax < tmax) tmax = tzmax;
+
+    if (tmax < 0) return false;
+
+    t = tmin > 0 ? tmin : tmax;
+    if (t < 0) return false;
+
+    hit = ray.origin + ray.direction * t;
+
+    // Compute normal
+    const float eps = 1e-4f;
+    if (std::fabs(hit.x - cube.min.x) < eps) normal = Vec3(-1,0,0);
+    else if (std::fabs(hit.x - cube.max.x) < eps) normal = Vec3(1,0,0);
+    else if (std::fabs(hit.y - cube.min.y) < eps) normal = Vec3(0,-1,0);
+    else if (std::fabs(hit.y - cube.max.y) < eps) normal = Vec3(0,1,0);
+    else if (std::fabs(hit.z - cube.min.z) < eps) normal = Vec3(0,0,-1);
+    else if (std::fabs(hit.z - cube.max.z) < eps) normal = Vec3(0,0,1);
+    else normal = Vec3(0,0,0);
+
+    return true;
+}
+
+// Ray-triangle intersection (Möller–Trumbore)
+inline bool intersect_triangle(const Ray& ray, const Triangle& tri, float& t, Vec3& hit, Vec3& normal) {
+    const float EPSILON = 1e-6f;
+    Vec3 edge1 = tri.v1 - tri.v0;
+    Vec3 edge2 = tri.v2 - tri.v0;
+    Vec3 h = ray.direction.cross(edge2);
+    float a = edge1.dot(h);
+    if (std::fabs(a) < EPSILON) return false;
+    float f = 1.0f / a;
+    Vec3 s = ray.origin - tri.v0;
+    float u = f * s.dot(h);
+    if (u < 0.0f || u > 1.0f) return false;
+    Vec3 q = s.cross(edge1);
+    float v = f * ray.direction.dot(q);
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = f * edge2.dot(q);
+    if (t > EPSILON) {
+        hit = ray.origin + ray.direction * t;
+        normal = edge1.cross(edge2).normalized();
+        return true;
+    }
+    return false;
+}
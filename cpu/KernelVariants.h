@@ -0,0 +1,107 @@
+// Kernel bodies, included once per instruction set by Kernels.cpp with
+// KERNEL_NAMESPACE and KERNEL_TARGET defined; no include guard on purpose.
+// Only plain floats and pointers are used here, so every comparison and
+// rounding step matches the scalar kernels in Intersect.h.
+
+namespace KERNEL_NAMESPACE {
+
+static const size_t CHUNK = 64;
+
+KERNEL_TARGET int nearestSphere(const PackedScene& packed, const Ray& ray, float& tMax) {
+    const float ox = ray.origin.x, oy = ray.origin.y, oz = ray.origin.z;
+    const float dx = ray.direction.x, dy = ray.direction.y, dz = ray.direction.z;
+    const float* cx = packed.cx.data();
+    const float* cy = packed.cy.data();
+    const float* cz = packed.cz.data();
+    const float* radius = packed.radius.data();
+    const size_t count = packed.sphereCount();
+
+    int best = -1;
+    float ts[CHUNK];
+    for (size_t base = 0; base < count; base += CHUNK) {
+        size_t n = count - base < CHUNK ? count - base : CHUNK;
+        for (size_t i = 0; i < n; ++i) {
+            float ocx = ox - cx[base + i], ocy = oy - cy[base + i], ocz = oz - cz[base + i];
+            float r = radius[base + i];
+            float b = 2.0f * (ocx * dx + ocy * dy + ocz * dz);
+            float c = (ocx * ocx + ocy * ocy + ocz * ocz) - r * r;
+            float disc = b * b - 4.0f * c;
+            float sqrtDisc = KERNEL_SQRT(disc > 0.0f ? disc : 0.0f);
+            float t0 = (-b - sqrtDisc) * 0.5f;
+            float t1 = (-b + sqrtDisc) * 0.5f;
+            float t = t0 > 0.0f ? t0 : t1;
+            t = t > 0.0f ? t : KERNEL_INFINITY;
+            ts[i] = disc >= 0.0f ? t : KERNEL_INFINITY;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (ts[i] < tMax) {
+                tMax = ts[i];
+                best = int(base + i);
+            }
+        }
+    }
+    return best;
+}
+
+KERNEL_TARGET int nearestTriangle(const PackedScene& packed, const Ray& ray, float& tMax) {
+    const float EPSILON = 1e-6f;
+    const float ox = ray.origin.x, oy = ray.origin.y, oz = ray.origin.z;
+    const float dx = ray.direction.x, dy = ray.direction.y, dz = ray.direction.z;
+    const float* v0x = packed.v0x.data();
+    const float* v0y = packed.v0y.data();
+    const float* v0z = packed.v0z.data();
+    const float* e1x = packed.e1x.data();
+    const float* e1y = packed.e1y.data();
+    const float* e1z = packed.e1z.data();
+    const float* e2x = packed.e2x.data();
+    const float* e2y = packed.e2y.data();
+    const float* e2z = packed.e2z.data();
+    const size_t count = packed.triangleCount();
+
+    int best = -1;
+    float ts[CHUNK];
+    for (size_t base = 0; base < count; base += CHUNK) {
+        size_t n = count - base < CHUNK ? count - base : CHUNK;
+        for (size_t i = 0; i < n; ++i) {
+            size_t k = base + i;
+            float hx = dy * e2z[k] - dz * e2y[k];
+            float hy = dz * e2x[k] - dx * e2z[k];
+            float hz = dx * e2y[k] - dy * e2x[k];
+            float a = e1x[k] * hx + e1y[k] * hy + e1z[k] * hz;
+            float f = 1.0f / a;
+            float sx = ox - v0x[k], sy = oy - v0y[k], sz = oz - v0z[k];
+            float u = f * (sx * hx + sy * hy + sz * hz);
+            float qx = sy * e1z[k] - sz * e1y[k];
+            float qy = sz * e1x[k] - sx * e1z[k];
+            float qz = sx * e1y[k] - sy * e1x[k];
+            float v = f * (dx * qx + dy * qy + dz * qz);
+            float t = f * (e2x[k] * qx + e2y[k] * qy + e2z[k] * qz);
+            bool hit = (KERNEL_FABS(a) >= EPSILON) & (u >= 0.0f) & (u <= 1.0f) & (v >= 0.0f) &
+                       (u + v <= 1.0f) & (t > EPSILON);
+            ts[i] = hit ? t : KERNEL_INFINITY;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (ts[i] < tMax) {
+                tMax = ts[i];
+                best = int(base + i);
+            }
+        }
+    }
+    return best;
+}
+
+KERNEL_TARGET void quantizeRgb8(const Vec3* pixels, size_t count, unsigned char* out) {
+    for (size_t i = 0; i < count; ++i) {
+        float r = pixels[i].x, g = pixels[i].y, b = pixels[i].z;
+        r = r < 0.0f ? 0.0f : (1.0f < r ? 1.0f : r);
+        g = g < 0.0f ? 0.0f : (1.0f < g ? 1.0f : g);
+        b = b < 0.0f ? 0.0f : (1.0f < b ? 1.0f : b);
+        out[3 * i + 0] = static_cast<unsigned char>(255.999f * r);
+        out[3 * i + 1] = static_cast<unsigned char>(255.999f * g);
+        out[3 * i + 2] = static_cast<unsigned char>(255.999f * b);
+    }
+}
+
+const KernelSet kernels = {KERNEL_NAME, nearestSphere, nearestTriangle, quantizeRgb8};
+
+}
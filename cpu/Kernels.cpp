@@ -0,0 +1,141 @@
+#include "Kernels.h"
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+void PackedScene::build(const Scene& scene) {
+    size_t spheres = scene.spheres.size(), triangles = scene.triangles.size();
+    for (auto* v : {&cx, &cy, &cz, &radius}) v->resize(spheres);
+    for (auto* v : {&v0x, &v0y, &v0z, &e1x, &e1y, &e1z, &e2x, &e2y, &e2z}) v->resize(triangles);
+
+    for (size_t i = 0; i < spheres; ++i) {
+        const Sphere& s = scene.spheres[i];
+        cx[i] = s.center.x;
+        cy[i] = s.center.y;
+        cz[i] = s.center.z;
+        radius[i] = s.radius;
+    }
+    for (size_t i = 0; i < triangles; ++i) {
+        const Triangle& tri = scene.triangles[i];
+        Vec3 e1 = tri.v1 - tri.v0, e2 = tri.v2 - tri.v0;
+        v0x[i] = tri.v0.x;
+        v0y[i] = tri.v0.y;
+        v0z[i] = tri.v0.z;
+        e1x[i] = e1.x;
+        e1y[i] = e1.y;
+        e1z[i] = e1.z;
+        e2x[i] = e2.x;
+        e2y[i] = e2.y;
+        e2z[i] = e2.z;
+    }
+}
+
+#define KERNEL_INFINITY std::numeric_limits<float>::infinity()
+#if defined(__GNUC__)
+#define KERNEL_SQRT __builtin_sqrtf
+#define KERNEL_FABS __builtin_fabsf
+#else
+#define KERNEL_SQRT std::sqrt
+#define KERNEL_FABS std::fabs
+#endif
+
+#define KERNEL_NAMESPACE generic_kernels
+#define KERNEL_TARGET
+#define KERNEL_NAME "generic"
+#include "KernelVariants.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+
+// Wider variants are x86 GCC/Clang only: function-level target attributes
+// keep everything else in this file (and any inline code it pulls in)
+// compiled for the baseline ISA.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BEAMLINE_X86_KERNELS 1
+
+#define KERNEL_NAMESPACE avx2_kernels
+#define KERNEL_TARGET __attribute__((target("avx2,fma")))
+#define KERNEL_NAME "avx2"
+#include "KernelVariants.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+
+#define KERNEL_NAMESPACE avx512_kernels
+#define KERNEL_TARGET __attribute__((target("avx512f,avx512vl,avx512bw,avx512dq,avx2,fma,prefer-vector-width=512")))
+#define KERNEL_NAME "avx512"
+#include "KernelVariants.h"
+#undef KERNEL_NAMESPACE
+#undef KERNEL_TARGET
+#undef KERNEL_NAME
+
+static bool cpu_has_avx2() {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+static bool cpu_has_avx512() {
+    return cpu_has_avx2() && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+           __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512dq");
+}
+#endif
+
+static const KernelSet* supported_kernels(const std::string& isa) {
+#if BEAMLINE_X86_KERNELS
+    if (isa == "avx512") return cpu_has_avx512() ? &avx512_kernels::kernels : nullptr;
+    if (isa == "avx2") return cpu_has_avx2() ? &avx2_kernels::kernels : nullptr;
+#endif
+    if (isa == "generic") return &generic_kernels::kernels;
+    return nullptr;
+}
+
+static const KernelSet* best_kernels() {
+    for (const std::string& isa : available_kernels()) {
+        if (const KernelSet* set = supported_kernels(isa)) return set;
+    }
+    return &generic_kernels::kernels;
+}
+
+static std::atomic<const KernelSet*> g_kernels{nullptr};
+
+const KernelSet& active_kernels() {
+    const KernelSet* set = g_kernels.load(std::memory_order_acquire);
+    if (!set) {
+        set = best_kernels();
+        g_kernels.store(set, std::memory_order_release);
+    }
+    return *set;
+}
+
+bool select_kernels(const std::string& isa) {
+    const KernelSet* set = isa == "auto" ? best_kernels() : supported_kernels(isa);
+    if (!set) return false;
+    g_kernels.store(set, std::memory_order_release);
+    return true;
+}
+
+std::vector<std::string> available_kernels() {
+#if BEAMLINE_X86_KERNELS
+    return {"avx512", "avx2", "generic"};
+#else
+    return {"generic"};
+#endif
+}
+
+std::string cpu_feature_summary() {
+    std::string features;
+#if BEAMLINE_X86_KERNELS
+    __builtin_cpu_init();
+    // __builtin_cpu_supports only takes string literals
+    const std::pair<const char*, bool> checks[] = {
+        {"sse4.2", __builtin_cpu_supports("sse4.2")},     {"avx", __builtin_cpu_supports("avx")},
+        {"avx2", __builtin_cpu_supports("avx2")},         {"fma", __builtin_cpu_supports("fma")},
+        {"avx512f", __builtin_cpu_supports("avx512f")},   {"avx512vl", __builtin_cpu_supports("avx512vl")},
+        {"avx512bw", __builtin_cpu_supports("avx512bw")}, {"avx512dq", __builtin_cpu_supports("avx512dq")},
+    };
+    for (const auto& [name, has] : checks) {
+        if (has) features += (features.empty() ? "" : " ") + std::string(name);
+    }
+#endif
+    return features.empty() ? "none detected" : features;
+}
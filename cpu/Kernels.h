@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "../Vec3.h"
+#include "../loader/SceneLoader.h"
+#include "Intersect.h"
+
+// Structure-of-arrays copy of the spheres and triangles, laid out for the
+// batch intersection kernels. Built once per render.
+struct PackedScene {
+    std::vector<float> cx, cy, cz, radius;                  // spheres
+    std::vector<float> v0x, v0y, v0z, e1x, e1y, e1z, e2x, e2y, e2z;   // triangles: v0, v1 - v0, v2 - v0
+
+    void build(const Scene& scene);
+    size_t sphereCount() const { return cx.size(); }
+    size_t triangleCount() const { return v0x.size(); }
+};
+
+// Hot loops compiled once per instruction set; all variants return
+// bit-identical results. nearest* return the index of the closest primitive
+// hit with t < tMax (updating tMax), or -1, using the same arithmetic as
+// intersect_sphere / intersect_triangle.
+struct KernelSet {
+    const char* name;
+    int (*nearestSphere)(const PackedScene& packed, const Ray& ray, float& tMax);
+    int (*nearestTriangle)(const PackedScene& packed, const Ray& ray, float& tMax);
+    // 8-bit RGB, clamped to [0, 1] and scaled by 255.999
+    void (*quantizeRgb8)(const Vec3* pixels, size_t count, unsigned char* out);
+};
+
+// Picked at startup from cpuid: avx512, avx2 or generic.
+const KernelSet& active_kernels();
+// "auto" or a variant name; false if unknown or not supported by this CPU.
+bool select_kernels(const std::string& isa);
+// Variant names built into this binary, best first.
+std::vector<std::string> available_kernels();
+// Instruction-set extensions of this CPU that the variants care about.
+std::string cpu_feature_summary();
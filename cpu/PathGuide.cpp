@@ -0,0 +1,263 @@
+#include "PathGuide.h"
+#include "Trace.h"
+#include <algorithm>
+#include <cmath>
+
+static const float PI = 3.14159265358979f;
+static const float ONE_MINUS_EPSILON = 0x1.fffffep-1f;
+// A direction cell is split while it holds more than this share of the energy
+static const float SPLIT_FRACTION = 0.01f;
+// A spatial leaf is split once an iteration of 2^k passes counted more than
+// SPATIAL_SPLIT_SAMPLES * sqrt(2^k) shading points in it
+static const double SPATIAL_SPLIT_SAMPLES = 12000.0;
+// Recorded values are summed as integers in units of 2^-16
+static const double FIXED_POINT_SCALE = 65536.0;
+static const float MAX_RECORDED_VALUE = 1e6f;
+
+static float component(const Vec3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static void set_component(Vec3& v, int axis, float value) {
+    if (axis == 0) v.x = value;
+    else if (axis == 1) v.y = value;
+    else v.z = value;
+}
+
+static void to_square(const Vec3& d, float& u, float& v) {
+    u = std::min(std::max(0.5f * (d.z + 1.0f), 0.0f), ONE_MINUS_EPSILON);
+    float phi = std::atan2(d.y, d.x);
+    if (phi < 0.0f) phi += 2.0f * PI;
+    v = std::min(std::max(phi / (2.0f * PI), 0.0f), ONE_MINUS_EPSILON);
+}
+
+static Vec3 from_square(float u, float v) {
+    float cosTheta = 2.0f * u - 1.0f;
+    float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+    float phi = 2.0f * PI * v;
+    return Vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+// Children are numbered x + 2y, x and y being the halves of the node's square
+Vec3 DirectionTree::sample(float u, float v, float& pdfOut) const {
+    float density = 1.0f, x0 = 0.0f, y0 = 0.0f, size = 1.0f;
+    uint32_t n = 0;
+    while (nodes[n].firstChild) {
+        const Node* c = &nodes[nodes[n].firstChild];
+        float total = nodes[n].energy;
+        float left = c[0].energy + c[2].energy;
+        float pu = left / total;
+        int ix = u < pu ? 0 : 1;
+        u = ix ? (u - pu) / (1.0f - pu) : u / pu;
+        float pv = c[ix].energy / (c[ix].energy + c[ix + 2].energy);
+        int iy = v < pv ? 0 : 1;
+        v = iy ? (v - pv) / (1.0f - pv) : v / pv;
+        u = std::min(u, ONE_MINUS_EPSILON);
+        v = std::min(v, ONE_MINUS_EPSILON);
+
+        int child = ix + 2 * iy;
+        density *= 4.0f * c[child].energy / total;
+        size *= 0.5f;
+        x0 += ix * size;
+        y0 += iy * size;
+        n = nodes[n].firstChild + child;
+    }
+    pdfOut = density / (4.0f * PI);
+    return from_square(x0 + u * size, y0 + v * size);
+}
+
+float DirectionTree::pdf(const Vec3& direction) const {
+    float u, v;
+    to_square(direction, u, v);
+    float density = 1.0f;
+    uint32_t n = 0;
+    while (nodes[n].firstChild) {
+        int ix = u < 0.5f ? 0 : 1, iy = v < 0.5f ? 0 : 1;
+        u = 2.0f * u - ix;
+        v = 2.0f * v - iy;
+        uint32_t child = nodes[n].firstChild + ix + 2 * iy;
+        if (!(nodes[child].energy > 0.0f)) return 0.0f;
+        density *= 4.0f * nodes[child].energy / nodes[n].energy;
+        n = child;
+    }
+    return density / (4.0f * PI);
+}
+
+uint32_t DirectionTree::leafAt(const Vec3& direction) const {
+    float u, v;
+    to_square(direction, u, v);
+    uint32_t n = 0;
+    while (nodes[n].firstChild) {
+        int ix = u < 0.5f ? 0 : 1, iy = v < 0.5f ? 0 : 1;
+        u = 2.0f * u - ix;
+        v = 2.0f * v - iy;
+        n = nodes[n].firstChild + ix + 2 * iy;
+    }
+    return n;
+}
+
+// Structure for the next iteration: cells holding more than SPLIT_FRACTION
+// of the energy are subdivided, breadth first until the node budget is spent;
+// the rest are merged. Energies are only copied to order the splits.
+static DirectionTree refined_structure(const DirectionTree& source) {
+    struct Item {
+        int source;   // -1 below the source tree's leaves
+        float energy;
+        int depth;
+        uint32_t node;
+    };
+    DirectionTree out;
+    float total = source.nodes[0].energy;
+    std::vector<Item> queue{{0, total, 0, 0}};
+    for (size_t q = 0; q < queue.size(); ++q) {
+        Item item = queue[q];
+        if (!(item.energy > SPLIT_FRACTION * total) || item.depth >= PathGuide::MAX_DIRECTION_DEPTH ||
+            out.nodes.size() + 4 > PathGuide::MAX_DIRECTION_NODES) {
+            continue;
+        }
+        uint32_t first = uint32_t(out.nodes.size());
+        out.nodes[item.node].firstChild = first;
+        out.nodes.resize(first + 4);
+        uint32_t sourceFirst = item.source >= 0 ? source.nodes[item.source].firstChild : 0;
+        for (uint32_t c = 0; c < 4; ++c) {
+            int child = sourceFirst ? int(sourceFirst + c) : -1;
+            float energy = child >= 0 ? source.nodes[child].energy : 0.25f * item.energy;
+            queue.push_back({child, energy, item.depth + 1, first + c});
+        }
+    }
+    return out;
+}
+
+void PathGuide::Leaf::startRecording(DirectionTree structure) {
+    recording = std::move(structure);
+    for (DirectionTree::Node& node : recording.nodes) node.energy = 0.0f;
+    energy.reset(new std::atomic<uint64_t>[recording.nodes.size()]);
+    for (size_t i = 0; i < recording.nodes.size(); ++i) energy[i].store(0, std::memory_order_relaxed);
+}
+
+PathGuide::PathGuide(const Scene& scene) {
+    boundsMin = boundsMax = scene.camera.position;
+    auto grow = [&](const Vec3& p) {
+        for (int a = 0; a < 3; ++a) {
+            set_component(boundsMin, a, std::min(component(boundsMin, a), component(p, a)));
+            set_component(boundsMax, a, std::max(component(boundsMax, a), component(p, a)));
+        }
+    };
+    for (const Sphere& s : scene.spheres) {
+        Vec3 r(s.radius, s.radius, s.radius);
+        grow(s.center - r);
+        grow(s.center + r);
+    }
+    for (const Cube& c : scene.cubes) {
+        grow(c.min);
+        grow(c.max);
+    }
+    for (const Triangle& t : scene.triangles) {
+        grow(t.v0);
+        grow(t.v1);
+        grow(t.v2);
+    }
+    for (const Light& l : scene.lights) grow(l.position);
+
+    // Cubic bounds keep the alternating splits roughly isotropic; hits on
+    // infinite planes beyond them are clamped to the border leaves
+    Vec3 center = (boundsMin + boundsMax) * 0.5f, extent = boundsMax - boundsMin;
+    float half = 0.505f * std::max(std::max(extent.x, extent.y), std::max(extent.z, 1e-3f));
+    boundsMin = center - Vec3(half, half, half);
+    boundsMax = center + Vec3(half, half, half);
+
+    spatial.push_back(SpatialNode{});
+    leaves.emplace_back(new Leaf());
+    leaves[0]->startRecording(DirectionTree());
+}
+
+PathGuide::Leaf& PathGuide::leafAt(const Vec3& position) const {
+    Vec3 lo = boundsMin, hi = boundsMax;
+    uint32_t n = 0;
+    while (spatial[n].firstChild) {
+        int axis = spatial[n].axis;
+        float mid = 0.5f * (component(lo, axis) + component(hi, axis));
+        if (component(position, axis) < mid) {
+            set_component(hi, axis, mid);
+            n = spatial[n].firstChild;
+        } else {
+            set_component(lo, axis, mid);
+            n = spatial[n].firstChild + 1;
+        }
+    }
+    return *leaves[spatial[n].leaf];
+}
+
+const DirectionTree* PathGuide::distribution(const Vec3& position) const {
+    if (iteration == 0) return nullptr;
+    const DirectionTree& tree = leafAt(position).sampling;
+    return tree.empty() ? nullptr : &tree;
+}
+
+void PathGuide::record(const Vec3& position, const Vec3& direction, float value) {
+    if (!(value > 0.0f)) return;
+    Leaf& leaf = leafAt(position);
+    uint64_t fixed = uint64_t(double(std::min(value, MAX_RECORDED_VALUE)) * FIXED_POINT_SCALE + 0.5);
+    leaf.energy[leaf.recording.leafAt(direction)].fetch_add(fixed, std::memory_order_relaxed);
+}
+
+void PathGuide::countSample(const Vec3& position) {
+    leafAt(position).samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+void PathGuide::refine() {
+    TRACE_SCOPE("render", "guide_refine");
+
+    for (auto& leaf : leaves) {
+        // Children always follow their parent, so one backward sweep sums the tree
+        DirectionTree learned = leaf->recording;
+        std::vector<uint64_t> sums(learned.nodes.size());
+        for (size_t i = learned.nodes.size(); i-- > 0;) {
+            uint32_t first = learned.nodes[i].firstChild;
+            sums[i] = first ? sums[first] + sums[first + 1] + sums[first + 2] + sums[first + 3]
+                            : leaf->energy[i].load(std::memory_order_relaxed);
+            learned.nodes[i].energy = float(double(sums[i]) / FIXED_POINT_SCALE);
+        }
+        // Nothing arrived here this iteration: keep what was learned before
+        if (learned.empty()) {
+            leaf->startRecording(leaf->recording);
+            continue;
+        }
+        leaf->sampling = std::move(learned);
+        leaf->startRecording(refined_structure(leaf->sampling));
+    }
+
+    // Split spatial leaves that saw many shading points; both halves start
+    // from the parent's distributions. Children are visited by the same loop.
+    double threshold = SPATIAL_SPLIT_SAMPLES * std::sqrt(std::ldexp(1.0, iteration));
+    for (size_t n = 0; n < spatial.size() && leaves.size() < MAX_SPATIAL_LEAVES; ++n) {
+        if (spatial[n].firstChild) continue;
+        Leaf& leaf = *leaves[spatial[n].leaf];
+        uint64_t samples = leaf.samples.load(std::memory_order_relaxed);
+        if (double(samples) <= threshold) continue;
+
+        std::unique_ptr<Leaf> twin(new Leaf());
+        twin->sampling = leaf.sampling;
+        twin->startRecording(leaf.recording);
+        twin->samples.store(samples / 2, std::memory_order_relaxed);
+        leaf.samples.store(samples - samples / 2, std::memory_order_relaxed);
+
+        uint32_t first = uint32_t(spatial.size());
+        int childAxis = (spatial[n].axis + 1) % 3;
+        spatial.push_back(SpatialNode{0, childAxis, spatial[n].leaf});
+        spatial.push_back(SpatialNode{0, childAxis, uint32_t(leaves.size())});
+        spatial[n].firstChild = first;
+        leaves.push_back(std::move(twin));
+    }
+    for (auto& leaf : leaves) leaf->samples.store(0, std::memory_order_relaxed);
+    ++iteration;
+}
+
+size_t PathGuide::memoryBytes() const {
+    size_t bytes = spatial.size() * sizeof(SpatialNode);
+    for (const auto& leaf : leaves) {
+        bytes += sizeof(Leaf) + leaf->sampling.nodes.size() * sizeof(DirectionTree::Node) +
+                 leaf->recording.nodes.size() * (sizeof(DirectionTree::Node) + sizeof(std::atomic<uint64_t>));
+    }
+    return bytes;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "../Vec3.h"
+#include "../loader/SceneLoader.h"
+
+// Distribution of directions over the sphere, stored as a quadtree over the
+// cylindrical mapping (cos theta, phi) -> [0, 1)^2, which preserves area.
+// Node energies are the sums of their children's.
+class DirectionTree {
+public:
+    struct Node {
+        uint32_t firstChild = 0;   // four consecutive children; 0 = leaf
+        float energy = 0.0f;
+    };
+    std::vector<Node> nodes;
+
+    DirectionTree() : nodes(1) {}
+    bool empty() const { return !(nodes[0].energy > 0.0f); }
+    // u, v in [0, 1) become a direction; pdfOut is its solid-angle density.
+    Vec3 sample(float u, float v, float& pdfOut) const;
+    float pdf(const Vec3& direction) const;
+    // Leaf holding the point of the unit square that direction maps to
+    uint32_t leafAt(const Vec3& direction) const;
+};
+
+// Learns where the light reaching each part of the scene comes from, so the
+// tracer can aim its gathering rays there (Mueller et al. 2017, "Practical
+// Path Guiding"). A kd-tree over the scene bounds holds one DirectionTree
+// per leaf. Training runs in iterations of 1, 2, 4, ... passes: each records
+// radiance estimates into a copy of the current structure, and refine()
+// turns that record into the next sampling distribution, splitting busy
+// spatial leaves and bright direction cells within fixed node budgets.
+// Recording is lock-free and sums in fixed point, so the learned trees do
+// not depend on thread count or scheduling.
+class PathGuide {
+public:
+    static constexpr uint32_t MAX_SPATIAL_LEAVES = 1024;
+    static constexpr uint32_t MAX_DIRECTION_NODES = 1021;   // per spatial leaf, 1 + 4k
+    static constexpr int MAX_DIRECTION_DEPTH = 16;
+
+    explicit PathGuide(const Scene& scene);
+
+    // Learned distribution around position; nullptr before the first
+    // refine() and where nothing was recorded.
+    const DirectionTree* distribution(const Vec3& position) const;
+
+    // Thread-safe. value estimates the light arriving along direction
+    // (already divided by the density it was sampled with).
+    void record(const Vec3& position, const Vec3& direction, float value);
+    // Counts one shading point, whether or not it found light
+    void countSample(const Vec3& position);
+
+    // Call between passes, when no thread is recording.
+    void refine();
+
+    int iterations() const { return iteration; }
+    size_t spatialLeaves() const { return leaves.size(); }
+    size_t memoryBytes() const;
+
+private:
+    struct SpatialNode {
+        uint32_t firstChild = 0;   // two consecutive children; 0 = leaf
+        int axis = 0;              // split axis of this node's children
+        uint32_t leaf = 0;         // index into leaves when firstChild == 0
+    };
+    struct Leaf {
+        DirectionTree sampling;
+        DirectionTree recording;   // structure only; sums live in energy
+        std::unique_ptr<std::atomic<uint64_t>[]> energy;
+        std::atomic<uint64_t> samples{0};
+
+        void startRecording(DirectionTree structure);
+    };
+
+    Vec3 boundsMin, boundsMax;
+    std::vector<SpatialNode> spatial;
+    std::vector<std::unique_ptr<Leaf>> leaves;
+    int iteration = 0;
+
+    Leaf& leafAt(const Vec3& position) const;
+};
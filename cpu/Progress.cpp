@@ -0,0 +1,111 @@
+#include "Progress.h"
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
+
+static std::atomic<ProgressMode> g_progressMode{ProgressMode::Bar};
+static std::atomic<FILE*> g_progressOutput{nullptr};   // nullptr = stderr
+
+bool parse_progress_mode(const std::string& name, ProgressMode& mode) {
+    if (name == "bar") mode = ProgressMode::Bar;
+    else if (name == "quiet") mode = ProgressMode::Quiet;
+    else if (name == "json") mode = ProgressMode::Json;
+    else return false;
+    return true;
+}
+
+void set_progress_mode(ProgressMode mode) {
+    g_progressMode.store(mode);
+}
+
+ProgressMode progress_mode() {
+    return g_progressMode.load();
+}
+
+bool set_progress_fd(int fd) {
+    if (fd == 2) {
+        g_progressOutput.store(nullptr);
+        return true;
+    }
+    FILE* file = fdopen(fd, "w");
+    if (!file) return false;
+    g_progressOutput.store(file);
+    return true;
+}
+
+// std::cout is redirected to stderr when stdout carries a video stream
+static bool console_is_terminal() {
+    FILE* console = std::cout.rdbuf() == std::cerr.rdbuf() ? stderr : stdout;
+    return isatty(fileno(console));
+}
+
+ProgressReporter::ProgressReporter(const std::string& task, uint64_t total, ProgressMode mode)
+    : task(task), total(total), mode(mode), start(std::chrono::steady_clock::now()) {
+    // A redrawn bar would only fill captured logs with carriage returns
+    if (mode == ProgressMode::Bar && !console_is_terminal()) this->mode = ProgressMode::Quiet;
+    if (this->mode != ProgressMode::Quiet && total > 0) reporter = std::thread([this] { run(); });
+}
+
+ProgressReporter::~ProgressReporter() {
+    finish();
+}
+
+void ProgressReporter::finish() {
+    if (!reporter.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    reporter.join();
+}
+
+void ProgressReporter::run() {
+    auto interval = mode == ProgressMode::Json ? std::chrono::milliseconds(1000) : std::chrono::milliseconds(100);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+        report(false);
+    }
+    report(true);
+}
+
+void ProgressReporter::report(bool final) {
+    uint64_t work = std::min(done.load(std::memory_order_relaxed), total);
+    double fraction = double(work) / double(total);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (mode == ProgressMode::Bar) {
+        const int barWidth = 50;
+        std::string bar(barWidth, ' ');
+        int pos = static_cast<int>(barWidth * fraction);
+        for (int i = 0; i < barWidth; ++i) {
+            if (i < pos) bar[i] = '=';
+            else if (i == pos) bar[i] = '>';
+        }
+        std::cout << "\r[" << bar << "] " << int(fraction * 100.0) << " %" << (final ? "\n" : "") << std::flush;
+        return;
+    }
+
+    double eta = fraction > 0.0 ? elapsed * (1.0 - fraction) / fraction : -1.0;
+    double raysPerSec = elapsed > 0.0 ? double(traced.load(std::memory_order_relaxed)) / elapsed : 0.0;
+    std::ostringstream event;
+    event.setf(std::ios::fixed);
+    event.precision(3);
+    event << "{\"event\": \"" << (final ? "done" : "progress") << "\", \"task\": \"" << task
+          << "\", \"done\": " << work << ", \"total\": " << total << ", \"percent\": " << fraction * 100.0
+          << ", \"elapsed\": " << elapsed << ", \"eta\": " << eta << ", \"rays_per_sec\": " << raysPerSec << "}\n";
+    FILE* output = g_progressOutput.load();
+    if (!output) output = stderr;
+    std::string line = event.str();
+    std::fwrite(line.data(), 1, line.size(), output);
+    std::fflush(output);
+}
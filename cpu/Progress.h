@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+enum class ProgressMode {
+    Bar,     // redrawn progress bar, only when the console is a terminal
+    Quiet,
+    Json,    // one NDJSON event per second: percent, ETA, rays/sec
+};
+
+bool parse_progress_mode(const std::string& name, ProgressMode& mode);
+// Process-wide mode for renders that show progress (Bar by default).
+void set_progress_mode(ProgressMode mode);
+ProgressMode progress_mode();
+// Json events go to this file descriptor (stderr by default), never to
+// stdout, which carries the human-readable log. False if fd is not open.
+bool set_progress_fd(int fd);
+
+// Progress of one task. Workers only add to relaxed atomic counters; a
+// single reporter thread samples them a few times per second and does all
+// console output, so render threads never lock or write.
+class ProgressReporter {
+public:
+    ProgressReporter(const std::string& task, uint64_t total, ProgressMode mode = progress_mode());
+    ~ProgressReporter();
+
+    void add(uint64_t work, uint64_t rays = 0) {
+        done.fetch_add(work, std::memory_order_relaxed);
+        if (rays) traced.fetch_add(rays, std::memory_order_relaxed);
+    }
+    // Stops the reporter after a last report; later adds are not shown.
+    void finish();
+
+private:
+    std::string task;
+    uint64_t total;
+    ProgressMode mode;
+    std::chrono::steady_clock::time_point start;
+    std::atomic<uint64_t> done{0}, traced{0};
+
+    std::thread reporter;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    void run();
+    void report(bool final);
+};
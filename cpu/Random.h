@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+// Counter-based random numbers: every value is a pure hash of where it is
+// used (seed, frame, pixel, sample, bounce, dimension), so there is no
+// generator state to share between threads and renders come out the same
+// for any thread count or tile order.
+
+// PCG-based integer hash (Jarzynski & Olano, "Hash Functions for GPU Rendering").
+inline uint32_t pcg_hash(uint32_t v) {
+    uint32_t state = v * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Top 24 bits as a float in [0, 1).
+inline float uint_to_unit_float(uint32_t v) {
+    return float(v >> 8) * (1.0f / 16777216.0f);
+}
+
+class SampleRng {
+public:
+    SampleRng(uint32_t seed, uint32_t frame, uint32_t pixel, uint32_t sample) {
+        key = pcg_hash(seed);
+        key = pcg_hash(key ^ frame);
+        key = pcg_hash(key ^ pixel);
+        key = pcg_hash(key ^ sample);
+    }
+
+    // Dimension `dimension` of bounce `bounce` (0 = camera sample).
+    uint32_t nextUint(uint32_t bounce, uint32_t dimension) const {
+        return pcg_hash(key ^ pcg_hash(bounce * DIMENSIONS_PER_BOUNCE + dimension));
+    }
+    float uniform(uint32_t bounce, uint32_t dimension) const {
+        return uint_to_unit_float(nextUint(bounce, dimension));
+    }
+
+    static constexpr uint32_t DIMENSIONS_PER_BOUNCE = 64;
+
+private:
+    uint32_t key;
+};
@@ -1,4 +1,9 @@
 #include "RayTracer.h"
+#include "Intersect.h"
+#include "RenderStats.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
 #include <limits>
 #define _USE_MATH_DEFINES
 #include <cmath>
@@ -8,7 +13,22 @@
 #ifndef M_PI
 #define M_PI 3.1415926535
 #endif
-void print_progress_bar(float progress);
+static const Vec3 BACKGROUND_COLOR(0.1f, 0.1f, 0.1f);
+static const int RENDER_TILE_SIZE = 32;
+static const int PROBE_STEP = 8;            // one probe ray per 8x8 block
+static const int ADAPTIVE_MIN_TILE = 8;
+static const int ADAPTIVE_MAX_TILE = 64;
+static const int ADAPTIVE_TILES_PER_THREAD = 8;
+static const float GUIDE_FRACTION = 0.5f;   // share of gathering rays drawn from the path guide
+
+static float luminance(const Vec3& c) {
+    return 0.2126f * c.x + 0.7152f * c.y + 0.0722f * c.z;
+}
+
+// What the AOVs record as a hit's albedo: the diffuse color plus the mirror share
+static Vec3 surface_albedo(const Material& mat) {
+    return mat.diffuse_color * (1.0f - mat.reflectivity) + Vec3(mat.reflectivity, mat.reflectivity, mat.reflectivity);
+}
 
 RayTracer::RayTracer(int w, int h, int depth)
     : width(w), height(h), maxDepth(depth), framebuffer(w * h) {}
@@ -17,231 +37,663 @@ const std::vector<Vec3>& RayTracer::getFramebuffer() const {
     return framebuffer;
 }
 
-void RayTracer::render(const Scene& scene) {
-    Vec3 forward = (scene.camera.lookat - scene.camera.position).normalized();
-    Vec3 right = forward.cross(Vec3(0, 1, 0)).normalized();
-    Vec3 up = right.cross(forward).normalized();
+CameraBasis::CameraBasis(const Camera& camera, int w, int h)
+    : origin(camera.position), width(w), height(h) {
+    forward = (camera.lookat - camera.position).normalized();
+    right = forward.cross(Vec3(0, 1, 0)).normalized();
+    up = right.cross(forward).normalized();
 
     float fov = 90.0f;
-    float aspect = float(width) / height;
-    float scale = tanf(fov * 0.5f * M_PI / 180.f);
+    aspect = float(width) / height;
+    scale = tanf(fov * 0.5f * M_PI / 180.f);
+}
+
+Ray CameraBasis::primaryRay(float px, float py) const {
+    float u = (2 * (px / width) - 1) * aspect * scale;
+    float v = (1 - 2 * (py / height)) * scale;
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            float u = (2 * ((x + 0.5f) / width) - 1) * aspect * scale;
-            float v = (1 - 2 * ((y + 0.5f) / height)) * scale;
+    Vec3 dir = (forward + right * u + up * v).normalized();
+    return Ray(origin, dir);
+}
 
-            Vec3 dir = (forward + right * u + up * v).normalized();
-            Ray ray(scene.camera.position, dir);
+bool CameraBasis::project(const Vec3& p, float& px, float& py) const {
+    Vec3 d = p - origin;
+    float z = d.dot(forward);
+    if (z <= 1e-6f) return false;
 
-            Vec3 color = trace(ray, scene, maxDepth);
-            framebuffer[y * width + x] = color;
-        }
-        print_progress_bar(float(y + 1) / height);
-    }
-    std::cout << std::endl;
+    float invZ = 1.0f / z;
+    px = (d.dot(right) * invZ / (aspect * scale) + 1) * 0.5f * width;
+    py = (1 - d.dot(up) * invZ / scale) * 0.5f * height;
+    return true;
 }
 
-Vec3 RayTracer::trace(const Ray& ray, const Scene& scene, int depth) {
-    if (depth <= 0) return Vec3(0, 0, 0);
+void RayTracer::setTemporalReuse(bool enabled, float errorBound) {
+    temporalEnabled = enabled;
+    temporalErrorBound = errorBound;
+    resetTemporalCache();
+}
 
-    Vec3 hit, normal;
-    Material mat;
-    if (!intersect(ray, scene, hit, normal, mat))
-        return Vec3(0.1f, 0.1f, 0.1f); // Background color
+void RayTracer::resetTemporalCache() {
+    historyValid = false;
+}
 
-    Vec3 color = mat.diffuse_color * 0.1f; // Ambient term
+void RayTracer::resumeFrom(const AccumulationBuffer& state) {
+    accumulation = state;
+    resumePending = true;
+}
 
-    // emission
-    color += mat.emission; 
-
-    for (const auto& light : scene.lights) {
-        Vec3 toLight = (light.position - hit).normalized();
-
-        // Shadow ray
-        Ray shadowRay(hit + normal * 0.001f, toLight);
-        Vec3 shadowHit, shadowNormal;
-        Material tmp;
-        if (!intersect(shadowRay, scene, shadowHit, shadowNormal, tmp)) {
-            float diff = std::max(normal.dot(toLight), 0.0f);
-            color += mat.diffuse_color * light.color * diff;
-        }
-    }
+void RayTracer::prepare(const Scene& scene) {
+    packed.build(scene);
+    emitters.build(scene);
+    kernels = &active_kernels();
+    features = specialized ? scene_features(scene) : unsigned(FEATURE_ALL);
+    sampler = make_sampler(samplerType, width, samplesPerPixel, seed, frame);
+    variant = &variant_table(std::make_index_sequence<FEATURE_MASK_COUNT>())[features];
+    guide.reset();
+    guideLearning = false;
+}
 
-    if (mat.reflectivity > 0.0f) {
-        Vec3 reflectDir = ray.direction - normal * 2.f * ray.direction.dot(normal);
-        Ray reflectRay(hit + normal * 0.001f, reflectDir);
-        color = color * (1.0f - mat.reflectivity) + trace(reflectRay, scene, depth - 1) * mat.reflectivity;
+void RayTracer::render(const Scene& scene) {
+    prepare(scene);
+    CameraBasis camera(scene.camera, width, height);
+    if (temporalEnabled) {
+        renderTemporal(scene, camera);
+    } else {
+        renderAccumulated(scene, camera, Tile{0, 0, width, height});
     }
-
-    return color;
 }
 
-bool RayTracer::intersect(const Ray& ray, const Scene& scene, Vec3& hit, Vec3& normal, Material& mat) {
-    float tMin = std::numeric_limits<float>::max();
-    bool found = false;
+void RayTracer::renderRegion(const Scene& scene, const Tile& tile) {
+    prepare(scene);
+    CameraBasis camera(scene.camera, width, height);
+    renderAccumulated(scene, camera, tile);
+}
 
-    for (const auto& s : scene.spheres) {
-        float t;
-        Vec3 hp, n;
-        if (intersectSphere(ray, s, t, hp, n) && t < tMin) {
-            tMin = t;
-            hit = hp;
-            normal = n;
-            mat = s.material;
-            found = true;
+// Sample s of a pixel is placed by the sampler from (pixel, s) alone; a
+// single sample lands on the pixel center.
+void RayTracer::renderAccumulated(const Scene& scene, const CameraBasis& camera, const Tile& tile) {
+    if (accumulation.width != width || accumulation.height != height) {
+        accumulation.reset(width, height);
+    } else if (!resumePending) {
+        accumulation.clear(tile);
+    }
+    if (aovs && (aovs->width != width || aovs->height != height || !resumePending)) aovs->reset(width, height);
+    resumePending = false;
+    if (costMap && (costMap->width != width || costMap->height != height)) costMap->reset(width, height);
+
+    int firstPass = int(accumulation.minSamples(tile));
+    int passes = samplesPerPixel - firstPass;
+    std::vector<Tile> tiles;
+    if (pool && passes > 0) tiles = planTiles(scene, camera, tile);
+    ProgressReporter progress("render", uint64_t(std::max(passes, 0)) * tile.area(), reportMode());
+    if (pathGuiding && passes > 1) guide.reset(new PathGuide(scene));
+
+    for (int pass = firstPass; pass < samplesPerPixel && !isCancelled(); ++pass) {
+        // Guide training iteration k spans passes 2^k - 1 to 2^(k+1) - 2; one
+        // is only recorded when some pass after it can use what it learns
+        int iterationEnd = 1;
+        while (iterationEnd < pass + 2) iterationEnd *= 2;
+        iterationEnd -= 2;
+        guideLearning = guide && iterationEnd < samplesPerPixel - 1;
+
+        auto renderRows = [&](const Tile& t) {
+            ScopedBusyTime busy;
+            RenderStats& stats = thread_render_stats();
+            uint64_t raysBefore = stats.totalRays();
+            for (int y = t.y0; y < t.y1 && !isCancelled(); ++y) {
+                for (int x = t.x0; x < t.x1; ++x) {
+                    int idx = y * width + x;
+                    // Resumed pixels may already be ahead of this pass
+                    if (accumulation.samples[idx] != uint32_t(pass)) continue;
+
+                    std::chrono::steady_clock::time_point start;
+                    uint64_t tests = 0, rays = 0;
+                    if (costMap) {
+                        start = std::chrono::steady_clock::now();
+                        tests = stats.totalTests();
+                        rays = stats.totalRays();
+                    }
+
+                    Ray ray = sampleRay(camera, x, y, uint32_t(pass));
+                    ++stats.primaryRays;
+                    PathState path{x, y, uint32_t(pass)};
+                    if (aovs) {
+                        // Same as trace(), keeping the primary hit for the AOVs
+                        Vec3 hit, normal, color = BACKGROUND_COLOR;
+                        Material mat;
+                        if (intersect(ray, scene, hit, normal, mat)) {
+                            color = shade(ray, scene, hit, normal, mat, maxDepth, path);
+                            aovs->add(idx, surface_albedo(mat), normal, (hit - ray.origin).length(), color);
+                        } else {
+                            aovs->add(idx, BACKGROUND_COLOR, Vec3(), 0.0f, color);
+                        }
+                        accumulation.sum[idx] += color;
+                    } else {
+                        accumulation.sum[idx] += trace(ray, scene, maxDepth, path);
+                    }
+                    ++accumulation.samples[idx];
+
+                    if (costMap) {
+                        costMap->nanoseconds[idx] += std::chrono::duration<float, std::nano>(
+                            std::chrono::steady_clock::now() - start).count();
+                        costMap->tests[idx] += float(stats.totalTests() - tests);
+                        costMap->rays[idx] += float(stats.totalRays() - rays);
+                    }
+                }
+            }
+            progress.add(uint64_t(t.area()), stats.totalRays() - raysBefore);
+        };
+
+        if (pool) {
+            // Pixels are independent, so tiles can finish in any order
+            TaskGroup group(*pool, poolPriority);
+            for (const Tile& t : tiles) {
+                group.run([&, t] {
+                    TRACE_SCOPE_ARGS("render", "tile", {"x0", t.x0}, {"y0", t.y0}, {"x1", t.x1}, {"y1", t.y1},
+                                     {"pass", pass});
+                    renderRows(t);
+                });
+            }
+            group.wait();
+        } else {
+            TRACE_SCOPE_ARGS("render", "pass", {"pass", pass});
+            for (int y = tile.y0; y < tile.y1 && !isCancelled(); ++y) {
+                renderRows(Tile{tile.x0, y, tile.x1, y + 1});
+            }
         }
+        if (guideLearning && pass == iterationEnd && !isCancelled()) guide->refine();
+        if (!isCancelled() && passCallback) passCallback(pass + 1);
     }
-
-    for (const auto& p : scene.planes) {
-        float t;
-        Vec3 hp, n;
-        if (intersectPlane(ray, p, t, hp, n) && t < tMin) {
-            tMin = t;
-            hit = hp;
-            normal = n;
-            mat = p.material;
-            found = true;
+    guideLearning = false;
+    progress.finish();
+
+    // Samples resumed from a checkpoint without AOVs are the first ones of
+    // their pixel; retrace their primary hits so the guides cover them too
+    if (aovs && !isCancelled()) {
+        for (int y = tile.y0; y < tile.y1; ++y) {
+            for (int x = tile.x0; x < tile.x1; ++x) {
+                int idx = y * width + x;
+                uint32_t missing = accumulation.samples[idx] - std::min(aovs->samples[idx], accumulation.samples[idx]);
+                for (uint32_t s = 0; s < missing; ++s) {
+                    Ray ray = sampleRay(camera, x, y, s);
+                    Vec3 hit, normal;
+                    Material mat;
+                    if (intersect(ray, scene, hit, normal, mat)) {
+                        aovs->addGeometry(idx, surface_albedo(mat), normal, (hit - ray.origin).length());
+                    } else {
+                        aovs->addGeometry(idx, BACKGROUND_COLOR, Vec3(), 0.0f);
+                    }
+                }
+            }
         }
     }
 
-    for (const auto& c : scene.cubes) {
-        float t;
-        Vec3 hp, n;
-        if (intersectCube(ray, c, t, hp, n) && t < tMin) {
-            tMin = t;
-            hit = hp;
-            normal = n;
-            mat = c.material;
-            found = true;
-        }
+    accumulation.resolve(framebuffer, tile);
+}
+
+Ray RayTracer::sampleRay(const CameraBasis& camera, int x, int y, uint32_t s) const {
+    float ox = 0.5f, oy = 0.5f;
+    if (samplesPerPixel > 1) {
+        ox = sampler->get(x, y, s, 0, SAMPLE_PIXEL_X);
+        oy = sampler->get(x, y, s, 0, SAMPLE_PIXEL_Y);
     }
-    for (const auto& tri : scene.triangles) {
-        float t;
-        Vec3 hp, n;
-        if (intersectTriangle(ray, tri, t, hp, n) && t < tMin) {
-            tMin = t;
-            hit = hp;
-            normal = n;
-            mat = tri.material;
-            found = true;
+    return camera.primaryRay(x + ox, y + oy);
+}
+
+void RayTracer::forEachTile(const Tile& region, const std::vector<Tile>& tiles,
+                            const std::function<void(const Tile&)>& work) {
+    if (!pool) {
+        for (int y = region.y0; y < region.y1 && !isCancelled(); ++y) {
+            work(Tile{region.x0, y, region.x1, y + 1});
         }
+        return;
+    }
+    TaskGroup group(*pool, poolPriority);
+    for (const Tile& t : tiles) {
+        group.run([&work, this, t] {
+            if (isCancelled()) return;
+            TRACE_SCOPE_ARGS("render", "tile", {"x0", t.x0}, {"y0", t.y0}, {"x1", t.x1}, {"y1", t.y1});
+            work(t);
+        });
     }
+    group.wait();
+}
 
-    return found;
+// Traces one primary ray per probe block and uses the primitive tests it
+// caused (shadow rays and reflections included) as that block's cost.
+std::vector<Tile> RayTracer::planTiles(const Scene& scene, const CameraBasis& camera, const Tile& region) {
+    if (!adaptiveTiles) return make_tiles(region, RENDER_TILE_SIZE);
+
+    TRACE_SCOPE("render", "cost_probe");
+    CostEstimate estimate;
+    estimate.reset(region, PROBE_STEP);
+    TaskGroup group(*pool, poolPriority);
+    for (int row = 0; row < estimate.rows; ++row) {
+        group.run([&, row] {
+            RenderStats& stats = thread_render_stats();
+            float py = std::min(region.y0 + (row + 0.5f) * PROBE_STEP, float(region.y1) - 0.5f);
+            for (int column = 0; column < estimate.columns; ++column) {
+                float px = std::min(region.x0 + (column + 0.5f) * PROBE_STEP, float(region.x1) - 0.5f);
+                uint64_t tests = stats.totalTests();
+                uint64_t shadow = stats.shadowRays, reflection = stats.reflectionRays;
+                trace(camera.primaryRay(px, py), scene, maxDepth, PathState{int(px), int(py)});
+                estimate.at(column, row) = float(stats.totalTests() - tests + 1);
+                // Probes are planning work, not image rays: keep them out of the ray counts
+                stats.probeRays += 1 + (stats.shadowRays - shadow) + (stats.reflectionRays - reflection);
+                stats.shadowRays = shadow;
+                stats.reflectionRays = reflection;
+            }
+        });
+    }
+    group.wait();
+
+    int targetTiles = (pool->size() + 1) * ADAPTIVE_TILES_PER_THREAD;
+    return plan_tiles(region, estimate, targetTiles, ADAPTIVE_MIN_TILE, ADAPTIVE_MAX_TILE);
 }
 
-bool RayTracer::intersectSphere(const Ray& ray, const Sphere& s, float& t, Vec3& hit, Vec3& normal) {
-    Vec3 oc = ray.origin - s.center;
-    float b = 2.0f * oc.dot(ray.direction);
-    float c = oc.dot(oc) - s.radius * s.radius;
-    float disc = b * b - 4 * c;
+// Tiles run on the pool like renderAccumulated. Sample 0 of each pixel
+// decides reuse: its hit is projected into the previous frame and the
+// history pixel there is reused if it cached the same point. A pixel is only
+// cached when all its samples hit diffuse surfaces facing the same way, so
+// edges and reflections are always reshaded.
+void RayTracer::renderTemporal(const Scene& scene, const CameraBasis& camera) {
+    bool reuse = historyValid && historyCamera.width == width && historyCamera.height == height;
+    nextHistory.resize(size_t(width) * height);
+    float boundSq = temporalErrorBound * temporalErrorBound;
+    std::atomic<int> reused{0};
+    TRACE_SCOPE("render", "temporal_frame");
+    Tile region{0, 0, width, height};
+    std::vector<Tile> tiles;
+    if (pool) tiles = planTiles(scene, camera, region);
+    ProgressReporter progress("render", uint64_t(width) * height, reportMode());
+
+    forEachTile(region, tiles, [&](const Tile& t) {
+        ScopedBusyTime busy;
+        RenderStats& stats = thread_render_stats();
+        uint64_t raysBefore = stats.totalRays();
+        int tileReused = 0;
+        for (int y = t.y0; y < t.y1 && !isCancelled(); ++y) {
+            for (int x = t.x0; x < t.x1; ++x) {
+                int idx = y * width + x;
+                Ray ray = sampleRay(camera, x, y, 0);
+                ++stats.primaryRays;
+
+                // Primary visibility is always re-evaluated; only the shading
+                // (shadow rays and reflections) is skipped for reused pixels.
+                Vec3 hit, normal;
+                Material mat;
+                bool found = intersect(ray, scene, hit, normal, mat);
+                bool reusable = found && mat.reflectivity <= 0.0f;
+                float px, py;
+                if (reusable && reuse && historyCamera.project(hit, px, py) && px >= 0.0f && py >= 0.0f &&
+                    px < float(width) && py < float(height)) {
+                    // Squared distances spare the square roots
+                    const TemporalPixel& cached = history[size_t(py) * width + size_t(px)];
+                    Vec3 drift = hit - cached.hit, view = hit - ray.origin;
+                    if (cached.reusable && drift.dot(drift) <= boundSq * view.dot(view) &&
+                        normal.dot(cached.normal) > 0.99f) {
+                        framebuffer[idx] = cached.color;
+                        nextHistory[idx] = cached;
+                        ++tileReused;
+                        continue;
+                    }
+                }
+
+                Vec3 sum = BACKGROUND_COLOR;
+                if (found) sum = shade(ray, scene, hit, normal, mat, maxDepth, PathState{x, y, 0});
+                for (int s = 1; s < samplesPerPixel; ++s) {
+                    Ray sampled = sampleRay(camera, x, y, uint32_t(s));
+                    ++stats.primaryRays;
+                    Vec3 sampleHit, sampleNormal;
+                    Material sampleMat;
+                    if (!intersect(sampled, scene, sampleHit, sampleNormal, sampleMat)) {
+                        sum += BACKGROUND_COLOR;
+                        reusable = false;
+                        continue;
+                    }
+                    reusable = reusable && sampleMat.reflectivity <= 0.0f && sampleNormal.dot(normal) > 0.99f;
+                    sum += shade(sampled, scene, sampleHit, sampleNormal, sampleMat, maxDepth,
+                                 PathState{x, y, uint32_t(s)});
+                }
+                framebuffer[idx] = sum / float(samplesPerPixel);
+                TemporalPixel& next = nextHistory[idx];
+                next.reusable = reusable;
+                if (reusable) {
+                    next.hit = hit;
+                    next.normal = normal;
+                    next.color = framebuffer[idx];
+                }
+            }
+        }
+        reused += tileReused;
+        progress.add(uint64_t(t.area()), stats.totalRays() - raysBefore);
+    });
+    reusedPixels = reused;
+
+    if (!isCancelled()) {
+        history.swap(nextHistory);
+        historyCamera = camera;
+        historyValid = true;
+    }
+}
+
+// Samples of a pixel are summed in pass order and averaged like
+// AccumulationBuffer::resolve, so the image matches renderAccumulated
+void RayTracer::renderGBuffer(const Scene& scene, GBuffer& gbuffer) {
+    prepare(scene);
+    CameraBasis camera(scene.camera, width, height);
+    gbuffer.resize(width, height, samplesPerPixel);
+    gbuffer.sceneKey = scene_geometry_hash(scene);
+    gbuffer.seed = seed;
+    gbuffer.sampler = uint32_t(samplerType);
+    TRACE_SCOPE("render", "gbuffer_frame");
+    Tile region{0, 0, width, height};
+    std::vector<Tile> tiles;
+    if (pool) tiles = planTiles(scene, camera, region);
+    ProgressReporter progress("render", uint64_t(width) * height, reportMode());
+
+    forEachTile(region, tiles, [&](const Tile& t) {
+        ScopedBusyTime busy;
+        RenderStats& stats = thread_render_stats();
+        uint64_t raysBefore = stats.totalRays();
+        for (int y = t.y0; y < t.y1 && !isCancelled(); ++y) {
+            for (int x = t.x0; x < t.x1; ++x) {
+                int idx = y * width + x;
+                Vec3 sum;
+                for (int s = 0; s < samplesPerPixel; ++s) {
+                    Ray ray = sampleRay(camera, x, y, uint32_t(s));
+                    ++stats.primaryRays;
+                    Vec3 hit, normal;
+                    Material mat;
+                    int id;
+                    if (!intersect(ray, scene, hit, normal, mat, &id)) {
+                        sum += BACKGROUND_COLOR;
+                        continue;
+                    }
+                    size_t k = size_t(idx) * samplesPerPixel + s;
+                    gbuffer.position[k] = hit;
+                    gbuffer.normal[k] = normal;
+                    gbuffer.materialId[k] = id;
+                    sum += shade(ray, scene, hit, normal, mat, maxDepth, PathState{x, y, uint32_t(s)});
+                }
+                framebuffer[idx] = sum / float(samplesPerPixel);
+            }
+        }
+        progress.add(uint64_t(t.area()), stats.totalRays() - raysBefore);
+    });
+}
 
-    if (disc < 0) return false;
+void RayTracer::relight(const Scene& scene, const GBuffer& gbuffer) {
+    prepare(scene);
+    CameraBasis camera(scene.camera, width, height);
+    TRACE_SCOPE("render", "relight");
+    Tile region{0, 0, width, height};
+    std::vector<Tile> tiles;
+    if (pool) tiles = make_tiles(region, RENDER_TILE_SIZE);
+    ProgressReporter progress("relight", uint64_t(width) * height, reportMode());
+
+    forEachTile(region, tiles, [&](const Tile& t) {
+        ScopedBusyTime busy;
+        RenderStats& stats = thread_render_stats();
+        uint64_t raysBefore = stats.totalRays();
+        for (int y = t.y0; y < t.y1 && !isCancelled(); ++y) {
+            for (int x = t.x0; x < t.x1; ++x) {
+                int idx = y * width + x;
+                Vec3 sum;
+                for (int s = 0; s < gbuffer.samples; ++s) {
+                    size_t k = size_t(idx) * gbuffer.samples + s;
+                    const Material* mat = scene_material(scene, gbuffer.materialId[k]);
+                    if (!mat) {
+                        sum += BACKGROUND_COLOR;
+                        continue;
+                    }
+                    // The primary ray is only needed for its direction (reflections)
+                    Ray ray = sampleRay(camera, x, y, uint32_t(s));
+                    sum += shade(ray, scene, gbuffer.position[k], gbuffer.normal[k], *mat, maxDepth,
+                                 PathState{x, y, uint32_t(s)});
+                }
+                framebuffer[idx] = sum / float(gbuffer.samples);
+            }
+        }
+        progress.add(uint64_t(t.area()), stats.totalRays() - raysBefore);
+    });
+}
 
-    float sqrtDisc = sqrtf(disc);
-    float t0 = (-b - sqrtDisc) * 0.5f;
-    float t1 = (-b + sqrtDisc) * 0.5f;
-    t = (t0 > 0) ? t0 : t1;
+template <unsigned Features>
+Vec3 RayTracer::traceVariant(const Ray& ray, const Scene& scene, int depth, const PathState& path) {
+    if (depth <= 0) return Vec3(0, 0, 0);
 
-    if (t <= 0) return false;
+    Vec3 hit, normal;
+    Material mat;
+    if (!intersectVariant<Features>(ray, scene, hit, normal, mat, nullptr))
+        return BACKGROUND_COLOR;
 
-    hit = ray.origin + ray.direction * t;
-    normal = (hit - s.center).normalized();
-    return true;
+    return shadeVariant<Features>(ray, scene, hit, normal, mat, depth, path);
 }
 
-bool RayTracer::intersectPlane(const Ray& ray, const Plane& p, float& t, Vec3& hit, Vec3& normalOut) {
-    float denom = p.normal.dot(ray.direction);
-    if (fabs(denom) < 1e-6) return false;
+template <unsigned Features>
+void RayTracer::addLight(const Light& light, const Scene& scene, const Vec3& hit, const Vec3& normal,
+                         const Material& mat, Vec3& color) {
+    Vec3 toLight = (light.position - hit).normalized();
+
+    // Shadow ray
+    Ray shadowRay(hit + normal * 0.001f, toLight);
+    ++thread_render_stats().shadowRays;
+    Vec3 shadowHit, shadowNormal;
+    Material tmp;
+    if (!intersectVariant<Features>(shadowRay, scene, shadowHit, shadowNormal, tmp, nullptr)) {
+        float diff = std::max(normal.dot(toLight), 0.0f);
+        color += mat.diffuse_color * light.color * diff;
+    }
+}
 
-    float tHit = (p.point - ray.origin).dot(p.normal) / denom;
-    if (tHit < 0) return false;
+template <unsigned Features>
+Vec3 RayTracer::sampleEmitters(const Scene& scene, const Vec3& hit, const Vec3& normal, const Material& mat,
+                               int depth, const PathState& path) {
+    Vec3 result;
+    if (mat.diffuse_color.x <= 0.0f && mat.diffuse_color.y <= 0.0f && mat.diffuse_color.z <= 0.0f) return result;
+    RenderStats& stats = thread_render_stats();
+    uint32_t bounce = uint32_t(maxDepth - depth);
+    auto dimension = [&](uint32_t d) { return sampler->get(path.x, path.y, path.sample, bounce, d); };
+    Vec3 origin = hit + normal * 0.001f;
+    const float invPi = 1.0f / float(M_PI);
+    if (guideLearning) guide->countSample(hit);
+
+    // With a trained guide, the gathering ray is drawn from it with
+    // probability GUIDE_FRACTION; its density is that of the mixture
+    const DirectionTree* guided = guide ? guide->distribution(hit) : nullptr;
+    auto gatherPdf = [&](const Vec3& dir, float cosine) {
+        float pdf = cosine * invPi;
+        return guided ? (1.0f - GUIDE_FRACTION) * pdf + GUIDE_FRACTION * guided->pdf(dir) : pdf;
+    };
+
+    // Emitter sampling; the gathering strategy would pick the same direction with density gatherPdf
+    EmitterSample light;
+    if (emitters.sample(scene, hit, dimension(SAMPLE_LIGHT_SELECT), dimension(SAMPLE_LIGHT_U),
+                        dimension(SAMPLE_LIGHT_V), light)) {
+        float cosine = normal.dot(light.direction);
+        if (cosine > 0.0f) {
+            ++stats.shadowRays;
+            Vec3 lightHit, lightNormal;
+            Material tmp;
+            int id;
+            if (intersectVariant<Features>(Ray(origin, light.direction), scene, lightHit, lightNormal, tmp, &id) &&
+                id == light.primitiveId &&
+                std::fabs((lightHit - origin).length() - light.distance) <= 1e-3f * light.distance + 2e-3f) {
+                float bsdfPdf = gatherPdf(light.direction, cosine);
+                float weight = light.pdf * light.pdf / (light.pdf * light.pdf + bsdfPdf * bsdfPdf);
+                result += mat.diffuse_color * light.emission * (invPi * cosine * weight / light.pdf);
+                if (guideLearning) {
+                    guide->record(hit, light.direction, luminance(light.emission) * cosine * weight / light.pdf);
+                }
+            }
+        }
+    }
 
-    t = tHit;
-    hit = ray.origin + ray.direction * t;
-    normalOut = p.normal;
-    return true;
+    // Cosine-weighted (or guided) sampling; only emitters found this way
+    // count, the rest of the scene's indirect light is left to the ambient term
+    float u = dimension(SAMPLE_REFLECT_U), v = dimension(SAMPLE_REFLECT_V);
+    Vec3 dir;
+    if (guided && u < GUIDE_FRACTION) {
+        float guidedPdf;
+        dir = guided->sample(u / GUIDE_FRACTION, v, guidedPdf);
+    } else {
+        if (guided) u = (u - GUIDE_FRACTION) / (1.0f - GUIDE_FRACTION);
+        dir = sample_cosine_hemisphere(normal, u, v);
+    }
+    float cosine = normal.dot(dir);
+    if (cosine > 0.0f) {
+        ++stats.shadowRays;
+        Vec3 emitterHit, emitterNormal;
+        Material emitter;
+        int id;
+        if (intersectVariant<Features>(Ray(origin, dir), scene, emitterHit, emitterNormal, emitter, &id) &&
+            (emitter.emission.x != 0.0f || emitter.emission.y != 0.0f || emitter.emission.z != 0.0f)) {
+            // 0 for emitters the list cannot sample (planes), which then get full weight here
+            float lightPdf = emitters.pdf(scene, id, hit, emitterHit, emitterNormal);
+            float bsdfPdf = gatherPdf(dir, cosine);
+            float weight = bsdfPdf * bsdfPdf / (bsdfPdf * bsdfPdf + lightPdf * lightPdf);
+            // diffuse / pi * cos / pdf; without a guide only the albedo is left
+            result += mat.diffuse_color * emitter.emission * (weight * (cosine * invPi / bsdfPdf));
+            if (guideLearning) guide->record(hit, dir, luminance(emitter.emission) * cosine * weight / bsdfPdf);
+        }
+    }
+    return result;
 }
 
-// Ray-AABB (cube) intersection
-bool RayTracer::intersectCube(const Ray& ray, const Cube& cube, float& t, Vec3& hit, Vec3& normal) {
-    float tmin = (cube.min.x - ray.origin.x) / ray.direction.x;
-    float tmax = (cube.max.x - ray.origin.x) / ray.direction.x;
-    if (tmin > tmax) std::swap(tmin, tmax);
+template <unsigned Features>
+Vec3 RayTracer::shadeVariant(const Ray& ray, const Scene& scene, const Vec3& hit, const Vec3& normal,
+                             const Material& mat, int depth, const PathState& path) {
+    RenderStats& stats = thread_render_stats();
+    stats.maxDepth = std::max(stats.maxDepth, maxDepth - depth + 1);
+    Vec3 color = mat.diffuse_color * 0.1f; // Ambient term
 
-    float tymin = (cube.min.y - ray.origin.y) / ray.direction.y;
-    float tymax = (cube.max.y - ray.origin.y) / ray.direction.y;
-    if (tymin > tymax) std::swap(tymin, tymax);
+    // emission
+    if (Features & FEATURE_EMISSION) color += mat.emission;
 
-    if ((tmin > tymax) || (tymin > tmax))
-        return false;
+    if (Features & FEATURE_MANY_LIGHTS) {
+        for (const auto& light : scene.lights) addLight<Features>(light, scene, hit, normal, mat, color);
+    } else if (Features & FEATURE_LIGHTS) {
+        addLight<Features>(scene.lights[0], scene, hit, normal, mat, color);
+    }
 
-    if (tymin > tmin) tmin = tymin;
-    if (tymax < tmax) tmax = tymax;
+    if (Features & FEATURE_EMISSION) {
+        color += sampleEmitters<Features>(scene, hit, normal, mat, depth, path);
+    }
 
-    float tzmin = (cube.min.z - ray.origin.z) / ray.direction.z;
-    float tzmax = (cube.max.z - ray.origin.z) / ray.direction.z;
-    if (tzmin > tzmax) std::swap(tzmin, tzmax);
+    if ((Features & FEATURE_REFLECTION) && mat.reflectivity > 0.0f) {
+        float weight = mat.reflectivity;
+        PathState next = path;
+        next.throughput = path.throughput * mat.reflectivity;
+        int bounce = maxDepth - depth + 1;
+        if (depth <= 1) {
+            // The reflection would return black anyway
+            weight = 0.0f;
+        } else if (next.throughput < minContribution) {
+            ++stats.cutoffPaths;
+            weight = 0.0f;
+        } else if (rouletteBounce > 0 && bounce >= rouletteBounce && next.throughput < ROULETTE_THRESHOLD) {
+            float survive = next.throughput / ROULETTE_THRESHOLD;
+            if (sampler->get(path.x, path.y, path.sample, uint32_t(bounce - 1), SAMPLE_ROULETTE) < survive) {
+                weight /= survive;
+                next.throughput = ROULETTE_THRESHOLD;
+            } else {
+                ++stats.roulettePaths;
+                weight = 0.0f;
+            }
+        }
 
-    if ((tmin > tzmax) || (tzmin > tmax))
-        return false;
+        color = color * (1.0f - mat.reflectivity);
+        if (weight > 0.0f) {
+            Vec3 reflectDir = ray.direction - normal * 2.f * ray.direction.dot(normal);
+            Ray reflectRay(hit + normal * 0.001f, reflectDir);
+            ++stats.reflectionRays;
+            color += traceVariant<Features>(reflectRay, scene, depth - 1, next) * weight;
+        }
+    }
 
-    if (tzmin > tmin) tmin = tzmin;
-    if (tzmax < tmax) tmax = tzmax;
+    return color;
+}
 
-    if (tmax < 0) return false;
+template <unsigned Features>
+bool RayTracer::intersectVariant(const Ray& ray, const Scene& scene, Vec3& hit, Vec3& normal, Material& mat,
+                                 int* primitiveId) {
+    float tMin = std::numeric_limits<float>::max();
+    bool found = false;
+    int id = 0, hitId = -1;
+    RenderStats& stats = thread_render_stats();
+
+    // Spheres and triangles go through the batch kernels, which only find
+    // the nearest one; its hit point and normal come from the scalar test
+    if (Features & FEATURE_SPHERES) {
+        int sphere = kernels->nearestSphere(packed, ray, tMin);
+        if (sphere >= 0) {
+            const Sphere& s = scene.spheres[sphere];
+            float t;
+            intersect_sphere(ray, s, t, hit, normal);
+            mat = s.material;
+            hitId = sphere;
+            found = true;
+        }
+        id += int(scene.spheres.size());
+        stats.sphereTests += scene.spheres.size();
+    }
 
-    t = tmin > 0 ? tmin : tmax;
-    if (t < 0) return false;
+    if (Features & FEATURE_PLANES) {
+        for (const auto& p : scene.planes) {
+            float t;
+            Vec3 hp, n;
+            if (intersect_plane(ray, p, t, hp, n) && t < tMin) {
+                tMin = t;
+                hit = hp;
+                normal = n;
+                mat = p.material;
+                hitId = id;
+                found = true;
+            }
+            ++id;
+        }
+        stats.planeTests += scene.planes.size();
+    }
 
-    hit = ray.origin + ray.direction * t;
+    if (Features & FEATURE_CUBES) {
+        for (const auto& c : scene.cubes) {
+            float t;
+            Vec3 hp, n;
+            if (intersect_cube(ray, c, t, hp, n) && t < tMin) {
+                tMin = t;
+                hit = hp;
+                normal = n;
+                mat = c.material;
+                hitId = id;
+                found = true;
+            }
+            ++id;
+        }
+        stats.cubeTests += scene.cubes.size();
+    }
 
-    // Compute normal
-    const float eps = 1e-4f;
-    if (fabs(hit.x - cube.min.x) < eps) normal = Vec3(-1,0,0);
-    else if (fabs(hit.x - cube.max.x) < eps) normal = Vec3(1,0,0);
-    else if (fabs(hit.y - cube.min.y) < eps) normal = Vec3(0,-1,0);
-    else if (fabs(hit.y - cube.max.y) < eps) normal = Vec3(0,1,0);
-    else if (fabs(hit.z - cube.min.z) < eps) normal = Vec3(0,0,-1);
-    else if (fabs(hit.z - cube.max.z) < eps) normal = Vec3(0,0,1);
-    else normal = Vec3(0,0,0);
+    if (Features & FEATURE_TRIANGLES) {
+        int triangle = kernels->nearestTriangle(packed, ray, tMin);
+        if (triangle >= 0) {
+            const Triangle& tri = scene.triangles[triangle];
+            float t;
+            intersect_triangle(ray, tri, t, hit, normal);
+            mat = tri.material;
+            hitId = id + triangle;
+            found = true;
+        }
+        stats.triangleTests += scene.triangles.size();
+    }
 
-    return true;
+    stats.hits += found;
+    if (primitiveId) *primitiveId = hitId;
+    return found;
 }
 
-// Ray-triangle intersection (Möller–Trumbore)
-bool RayTracer::intersectTriangle(const Ray& ray, const Triangle& tri, float& t, Vec3& hit, Vec3& normal) {
-    const float EPSILON = 1e-6f;
-    Vec3 edge1 = tri.v1 - tri.v0;
-    Vec3 edge2 = tri.v2 - tri.v0;
-    Vec3 h = ray.direction.cross(edge2);
-    float a = edge1.dot(h);
-    if (fabs(a) < EPSILON) return false;
-    float f = 1.0f / a;
-    Vec3 s = ray.origin - tri.v0;
-    float u = f * s.dot(h);
-    if (u < 0.0f || u > 1.0f) return false;
-    Vec3 q = s.cross(edge1);
-    float v = f * ray.direction.dot(q);
-    if (v < 0.0f || u + v > 1.0f) return false;
-    t = f * edge2.dot(q);
-    if (t > EPSILON) {
-        hit = ray.origin + ray.direction * t;
-        normal = edge1.cross(edge2).normalized();
-        return true;
-    }
-    return false;
-}
-
-void print_progress_bar(float progress) {
-    const int barWidth = 50;
-    std::cout << "\r[";
-    int pos = static_cast<int>(barWidth * progress);
-    for (int i = 0; i < barWidth; ++i) {
-        if (i < pos) std::cout << "=";
-        else if (i == pos) std::cout << ">";
-        else std::cout << " ";
-    }
-    std::cout << "] " << int(progress * 100.0) << " %" << std::flush;
-}
\ No newline at end of file
+template <size_t... Masks>
+const RayTracer::Variant* RayTracer::variant_table(std::index_sequence<Masks...>) {
+    static const Variant table[] = {
+        {&RayTracer::traceVariant<Masks>, &RayTracer::shadeVariant<Masks>, &RayTracer::intersectVariant<Masks>}...};
+    return table;
+}
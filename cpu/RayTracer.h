@@ -1,13 +1,47 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <utility>
 #include <vector>
 #include "../Vec3.h"
 #include "../loader/SceneLoader.h"
+#include "GBuffer.h"
+#include "Checkpoint.h"
+#include "Tile.h"
+#include "ThreadPool.h"
+#include "Intersect.h"
+#include "CostMap.h"
+#include "TilePlanner.h"
+#include "Sampler.h"
+#include "Progress.h"
+#include "Kernels.h"
+#include "SceneFeatures.h"
+#include "Emitters.h"
+#include "Denoiser.h"
+#include "PathGuide.h"
 
-struct Ray {
-    Vec3 origin;
-    Vec3 direction;
+// Pinhole camera frame for a given image size (90 degree vertical FOV).
+struct CameraBasis {
+    Vec3 origin, forward, right, up;
+    float aspect = 1.0f, scale = 1.0f;
+    int width = 0, height = 0;
 
-    Ray(const Vec3& o, const Vec3& d) : origin(o), direction(d.normalized()) {}
+    CameraBasis() = default;
+    CameraBasis(const Camera& camera, int width, int height);
+
+    // px, py are continuous pixel coordinates (pixel centers at +0.5)
+    Ray primaryRay(float px, float py) const;
+    // Inverse of primaryRay; false when p is behind the camera
+    bool project(const Vec3& p, float& px, float& py) const;
+};
+
+// One camera path: the pixel and sample it belongs to (keys its random
+// decisions) and the weight its radiance will have in that pixel.
+struct PathState {
+    int x = 0, y = 0;
+    uint32_t sample = 0;
+    float throughput = 1.0f;
 };
 
 class RayTracer {
@@ -15,17 +49,174 @@ public:
     RayTracer(int width, int height, int maxDepth = 4);
 
     void render(const Scene& scene);
+    // Renders only the pixels inside tile; the rest of the framebuffer is left as is.
+    void renderRegion(const Scene& scene, const Tile& tile);
     const std::vector<Vec3>& getFramebuffer() const;
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // Progress is reported in the process-wide progress_mode() when shown.
+    void setShowProgress(bool show) { showProgress = show; }
+    // render() splits the image into tiles on the pool (nullptr = calling thread only).
+    void setThreadPool(ThreadPool* threadPool, int priority = 0) { pool = threadPool; poolPriority = priority; }
+    // Pool renders size tiles from a low-resolution probe pass (on by default):
+    // costly regions get smaller tiles and are scheduled first.
+    void setAdaptiveTiles(bool enabled) { adaptiveTiles = enabled; }
+    // Each render runs the tracer variant compiled for the scene's
+    // SceneFeature mask (on by default); off runs the all-features variant.
+    void setSpecialized(bool enabled) { specialized = enabled; }
+    // Mask of the variant used by the last render.
+    unsigned getFeatures() const { return features; }
+
+    // Records per-pixel time, primitive tests and rays of render() into map
+    // (resized to the image if needed, otherwise added to); nullptr disables.
+    void setCostMap(CostMap* map) { costMap = map; }
+    // Records albedo, normal and depth of every sample's primary hit in
+    // render() for the denoiser; cleared unless resuming. nullptr disables.
+    void setAovBuffer(AovBuffer* buffer) { aovs = buffer; }
+    // Learns the light arriving at each part of the scene over the passes of
+    // render() and aims the emitters' cosine-weighted rays with it (off by
+    // default). The guide lives for one render; the last one stays readable.
+    void setPathGuiding(bool enabled) { pathGuiding = enabled; }
+    const PathGuide* getPathGuide() const { return guide.get(); }
+
+    // Samples per pixel for render(). Samples are added one pass over the
+    // image at a time; the callback runs after each completed pass.
+    void setSamplesPerPixel(int spp) { samplesPerPixel = spp; }
+    int getSamplesPerPixel() const { return samplesPerPixel; }
+    // Keys the per-sample random numbers; the frame index decorrelates
+    // animation frames rendered with the same seed.
+    void setSeed(uint32_t value) { seed = value; }
+    uint32_t getSeed() const { return seed; }
+    void setFrame(uint32_t index) { frame = index; }
+    // Reflections stop once their weight in the pixel drops below
+    // minContribution. From bounce rouletteBounce on (0 = never), paths
+    // weighing less than ROULETTE_THRESHOLD are continued with probability
+    // weight / ROULETTE_THRESHOLD and reweighted, which keeps the estimate
+    // unbiased.
+    void setRoulette(int bounce) { rouletteBounce = bounce; }
+    void setMinContribution(float weight) { minContribution = weight; }
+    static constexpr float ROULETTE_THRESHOLD = 0.05f;
+    // Where samples are placed when spp > 1 (stratified by default).
+    void setSampler(SamplerType type) { samplerType = type; }
+    SamplerType getSampler() const { return samplerType; }
+    void setPassCallback(std::function<void(int completedPasses)> callback) { passCallback = std::move(callback); }
+    const AccumulationBuffer& getAccumulation() const { return accumulation; }
+    // Makes the next render() continue from this state instead of starting over.
+    void resumeFrom(const AccumulationBuffer& state);
+
+    // Renders all samples per pixel at once while recording every sample's
+    // primary hit; the image matches render() with the same settings.
+    void renderGBuffer(const Scene& scene, GBuffer& gbuffer);
+    // Reshades a recorded G-buffer; only shadow rays and reflections are
+    // traced. It must have been recorded with this tracer's spp, seed and sampler.
+    void relight(const Scene& scene, const GBuffer& gbuffer);
+
+    // Rendering stops at the next scanline once *flag becomes true; the
+    // framebuffer is then only partially updated.
+    void setCancelFlag(const std::atomic<bool>* flag) { cancelFlag = flag; }
+    bool isCancelled() const { return cancelFlag && cancelFlag->load(std::memory_order_relaxed); }
+
+    // Temporal reuse across frames of a static scene: pixels whose first hit
+    // reprojects from the previous frame to within errorBound (relative to hit
+    // distance) keep their cached shading instead of being retraced.
+    void setTemporalReuse(bool enabled, float errorBound = 0.01f);
+    void resetTemporalCache();
+    int getReusedPixelCount() const { return reusedPixels; }
 
 private:
     int width, height;
     int maxDepth;
+    int rouletteBounce = 3;
+    float minContribution = 0.001f;
     std::vector<Vec3> framebuffer;
+    const std::atomic<bool>* cancelFlag = nullptr;
+    bool showProgress = true;
+    ThreadPool* pool = nullptr;
+    int poolPriority = 0;
+    CostMap* costMap = nullptr;
+    AovBuffer* aovs = nullptr;
+    bool pathGuiding = false;
+    std::unique_ptr<PathGuide> guide;
+    bool guideLearning = false;   // the current pass records into guide
+    bool adaptiveTiles = true;
+    PackedScene packed;
+    EmitterList emitters;
+    const KernelSet* kernels = nullptr;
+    bool specialized = true;
+    unsigned features = FEATURE_ALL;
+
+    // trace / shade / intersect compiled for one feature mask
+    struct Variant {
+        Vec3 (RayTracer::*trace)(const Ray&, const Scene&, int, const PathState&);
+        Vec3 (RayTracer::*shade)(const Ray&, const Scene&, const Vec3&, const Vec3&, const Material&, int,
+                                 const PathState&);
+        bool (RayTracer::*intersect)(const Ray&, const Scene&, Vec3&, Vec3&, Material&, int*);
+    };
+    template <size_t... Masks> static const Variant* variant_table(std::index_sequence<Masks...>);
+    const Variant* variant = nullptr;
+
+    int samplesPerPixel = 1;
+    uint32_t seed = 0;
+    uint32_t frame = 0;
+    SamplerType samplerType = SamplerType::Stratified;
+    std::unique_ptr<Sampler> sampler;
+    AccumulationBuffer accumulation;
+    bool resumePending = false;
+    std::function<void(int)> passCallback;
+
+    bool temporalEnabled = false;
+    float temporalErrorBound = 0.01f;
+    bool historyValid = false;
+    int reusedPixels = 0;
+    // One record per pixel, so a reuse test reads one record instead of four arrays
+    struct TemporalPixel {
+        Vec3 hit;        // shading point the cached color came from
+        Vec3 normal;
+        Vec3 color;
+        bool reusable = false;   // hit, normal and color are only set when true
+    };
+    std::vector<TemporalPixel> history;
+    CameraBasis historyCamera;
+    // Next frame's history, swapped in when a frame completes; kept between
+    // frames so each one does not fault in fresh pages
+    std::vector<TemporalPixel> nextHistory;
+
+    // Packs the scene for the intersection kernels and picks the tracer
+    // variant; every entry point calls it
+    void prepare(const Scene& scene);
+    ProgressMode reportMode() const { return showProgress ? progress_mode() : ProgressMode::Quiet; }
+    void renderAccumulated(const Scene& scene, const CameraBasis& camera, const Tile& tile);
+    // Primary ray of sample s of pixel (x, y)
+    Ray sampleRay(const CameraBasis& camera, int x, int y, uint32_t s) const;
+    // Runs work on each tile on the pool, or scanline by scanline on the
+    // calling thread; stops handing out work once cancelled
+    void forEachTile(const Tile& region, const std::vector<Tile>& tiles, const std::function<void(const Tile&)>& work);
+    std::vector<Tile> planTiles(const Scene& scene, const CameraBasis& camera, const Tile& region);
+    void renderTemporal(const Scene& scene, const CameraBasis& camera);
+
+    Vec3 trace(const Ray& ray, const Scene& scene, int depth, const PathState& path) {
+        return (this->*variant->trace)(ray, scene, depth, path);
+    }
+    Vec3 shade(const Ray& ray, const Scene& scene, const Vec3& hit, const Vec3& normal, const Material& mat, int depth,
+               const PathState& path) {
+        return (this->*variant->shade)(ray, scene, hit, normal, mat, depth, path);
+    }
+    bool intersect(const Ray& ray, const Scene& scene, Vec3& hitPoint, Vec3& normal, Material& mat, int* primitiveId = nullptr) {
+        return (this->*variant->intersect)(ray, scene, hitPoint, normal, mat, primitiveId);
+    }
 
-    Vec3 trace(const Ray& ray, const Scene& scene, int depth);
-    bool intersect(const Ray& ray, const Scene& scene, Vec3& hitPoint, Vec3& normal, Material& mat);
-    bool intersectSphere(const Ray& ray, const Sphere& sphere, float& t, Vec3& hit, Vec3& normal);
-    bool intersectPlane(const Ray& ray, const Plane& plane, float& t, Vec3& hit, Vec3& normal);
-    bool intersectCube(const Ray& ray, const Cube& cube, float& t, Vec3& hit, Vec3& normal);
-    bool intersectTriangle(const Ray& ray, const Triangle& tri, float& t, Vec3& hit, Vec3& normal);
+    template <unsigned Features>
+    Vec3 traceVariant(const Ray& ray, const Scene& scene, int depth, const PathState& path);
+    template <unsigned Features>
+    Vec3 shadeVariant(const Ray& ray, const Scene& scene, const Vec3& hit, const Vec3& normal, const Material& mat,
+                      int depth, const PathState& path);
+    template <unsigned Features>
+    bool intersectVariant(const Ray& ray, const Scene& scene, Vec3& hitPoint, Vec3& normal, Material& mat, int* primitiveId);
+    // Direct light from emissive primitives: one emitter sample and one
+    // cosine-weighted (or guided) ray, combined with the power heuristic
+    template <unsigned Features>
+    Vec3 sampleEmitters(const Scene& scene, const Vec3& hit, const Vec3& normal, const Material& mat, int depth,
+                        const PathState& path);
+    template <unsigned Features>
+    void addLight(const Light& light, const Scene& scene, const Vec3& hit, const Vec3& normal, const Material& mat, Vec3& color);
 };
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "Relight.h"
+#include <iostream>
+
+RelightSession::RelightSession(const Scene& s, int width, int height, int maxDepth)
+    : scene(s), tracer(width, height, maxDepth) {}
+
+bool RelightSession::loadCache(const std::string& filename) {
+    GBuffer cached;
+    if (!cached.load(filename)) return false;
+
+    // Sample positions only depend on seed and sampler with several samples
+    bool samplesMatch = cached.samples == tracer.getSamplesPerPixel() &&
+                        (cached.samples == 1 || (cached.seed == tracer.getSeed() &&
+                                                 cached.sampler == uint32_t(tracer.getSampler())));
+    if (cached.width != tracer.getWidth() || cached.height != tracer.getHeight() || !samplesMatch ||
+        cached.sceneKey != scene_geometry_hash(scene)) {
+        std::cerr << "[WARNING] G-buffer " << filename
+                  << " is stale (camera, geometry, resolution or sampling changed).\n";
+        return false;
+    }
+    gbuffer = std::move(cached);
+    gbufferValid = true;
+    return true;
+}
+
+bool RelightSession::saveCache(const std::string& filename) const {
+    return gbufferValid && gbuffer.save(filename);
+}
+
+bool RelightSession::applyLightDelta(const LightDelta& delta) {
+    if (delta.index > scene.lights.size() || (delta.remove && delta.index == scene.lights.size())) {
+        std::cerr << "[ERROR] Light index out of range: " << delta.index << "\n";
+        return false;
+    }
+    if (delta.remove) {
+        scene.lights.erase(scene.lights.begin() + delta.index);
+    } else if (delta.index == scene.lights.size()) {
+        scene.lights.push_back(delta.light);
+    } else {
+        scene.lights[delta.index] = delta.light;
+    }
+    return true;
+}
+
+void RelightSession::setLights(const std::vector<Light>& lights) {
+    scene.lights = lights;
+}
+
+const std::vector<Vec3>& RelightSession::render() {
+    if (gbufferValid) {
+        tracer.relight(scene, gbuffer);
+    } else {
+        tracer.renderGBuffer(scene, gbuffer);
+        gbufferValid = true;
+    }
+    return tracer.getFramebuffer();
+}
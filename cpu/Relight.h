@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "RayTracer.h"
+
+// Change to one light. index == lights.size() appends a new light.
+struct LightDelta {
+    size_t index = 0;
+    Light light;
+    bool remove = false;
+};
+
+// Keeps a scene and its primary-hit G-buffer alive so that light edits
+// only pay for shading and shadow rays. Intended for long-lived callers
+// (lighting tools, daemons) as well as the --relight CLI mode.
+class RelightSession {
+public:
+    RelightSession(const Scene& scene, int width, int height, int maxDepth = 4);
+
+    // Adopts a G-buffer saved by an earlier session; fails if it was built
+    // for a different resolution, camera, geometry or sample placement.
+    // Set the sampling options below first.
+    bool loadCache(const std::string& filename);
+    bool saveCache(const std::string& filename) const;
+    bool hasGBuffer() const { return gbufferValid; }
+
+    bool applyLightDelta(const LightDelta& delta);
+    void setLights(const std::vector<Light>& lights);
+
+    // Full render on first use (recording the G-buffer), shading-only afterwards.
+    const std::vector<Vec3>& render();
+
+    const Scene& getScene() const { return scene; }
+    void setShowProgress(bool show) { tracer.setShowProgress(show); }
+    void setRoulette(int bounce) { tracer.setRoulette(bounce); }
+    void setMinContribution(float weight) { tracer.setMinContribution(weight); }
+    void setThreadPool(ThreadPool* pool) { tracer.setThreadPool(pool); }
+    void setSamplesPerPixel(int spp) { tracer.setSamplesPerPixel(spp); }
+    void setSeed(uint32_t seed) { tracer.setSeed(seed); }
+    void setSampler(SamplerType type) { tracer.setSampler(type); }
+
+private:
+    Scene scene;
+    RayTracer tracer;
+    GBuffer gbuffer;
+    bool gbufferValid = false;
+};
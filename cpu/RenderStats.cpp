@@ -0,0 +1,98 @@
+#include "RenderStats.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+static std::mutex g_statsMutex;
+static std::vector<std::unique_ptr<RenderStats>> g_threadStats;
+
+void RenderStats::merge(const RenderStats& o) {
+    primaryRays += o.primaryRays;
+    shadowRays += o.shadowRays;
+    reflectionRays += o.reflectionRays;
+    probeRays += o.probeRays;
+    sphereTests += o.sphereTests;
+    planeTests += o.planeTests;
+    cubeTests += o.cubeTests;
+    triangleTests += o.triangleTests;
+    hits += o.hits;
+    cutoffPaths += o.cutoffPaths;
+    roulettePaths += o.roulettePaths;
+    maxDepth = std::max(maxDepth, o.maxDepth);
+    busySeconds += o.busySeconds;
+}
+
+RenderStats* register_thread_stats() {
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    g_threadStats.push_back(std::make_unique<RenderStats>());
+    return g_threadStats.back().get();
+}
+
+StatsSnapshot collect_render_stats() {
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    StatsSnapshot snapshot;
+    for (const auto& stats : g_threadStats) {
+        snapshot.total.merge(*stats);
+        if (stats->busySeconds > 0.0) snapshot.threadBusySeconds.push_back(stats->busySeconds);
+    }
+    return snapshot;
+}
+
+void reset_render_stats() {
+    std::lock_guard<std::mutex> lock(g_statsMutex);
+    for (auto& stats : g_threadStats) *stats = RenderStats();
+}
+
+static std::string json_escape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+bool write_stats_json(const std::string& filename, const StatsReportInfo& info, const StatsSnapshot& stats) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "[ERROR] Couldn't open file: " << filename << "\n";
+        return false;
+    }
+
+    const RenderStats& s = stats.total;
+    double rate = info.renderSeconds > 0.0 ? s.totalRays() / info.renderSeconds : 0.0;
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n";
+    out << "  \"scene\": \"" << json_escape(info.scene) << "\",\n";
+    out << "  \"width\": " << info.width << ",\n";
+    out << "  \"height\": " << info.height << ",\n";
+    out << "  \"spp\": " << info.samplesPerPixel << ",\n";
+    out << "  \"seed\": " << info.seed << ",\n";
+    out << "  \"sampler\": \"" << info.sampler << "\",\n";
+    out << "  \"kernels\": \"" << info.kernels << "\",\n";
+    out << "  \"features\": \"" << info.features << "\",\n";
+    out << "  \"frames\": " << info.frames << ",\n";
+    out << "  \"threads\": " << info.threads << ",\n";
+    out << "  \"phases\": {\"load\": " << info.loadSeconds << ", \"render\": " << info.renderSeconds
+        << ", \"save\": " << info.saveSeconds << ", \"total\": "
+        << info.loadSeconds + info.renderSeconds + info.saveSeconds << "},\n";
+    out << "  \"rays\": {\"primary\": " << s.primaryRays << ", \"shadow\": " << s.shadowRays
+        << ", \"reflection\": " << s.reflectionRays << ", \"total\": " << s.totalRays()
+        << ", \"probe\": " << s.probeRays << "},\n";
+    out << "  \"rays_per_sec\": " << std::setprecision(1) << rate << ",\n" << std::setprecision(6);
+    out << "  \"primitive_tests\": {\"sphere\": " << s.sphereTests << ", \"plane\": " << s.planeTests
+        << ", \"cube\": " << s.cubeTests << ", \"triangle\": " << s.triangleTests << ", \"total\": "
+        << s.totalTests() << "},\n";
+    out << "  \"hits\": " << s.hits << ",\n";
+    out << "  \"terminated_paths\": {\"cutoff\": " << s.cutoffPaths << ", \"roulette\": " << s.roulettePaths << "},\n";
+    out << "  \"max_depth\": " << s.maxDepth << ",\n";
+    out << "  \"thread_busy_seconds\": [";
+    for (size_t i = 0; i < stats.threadBusySeconds.size(); ++i) {
+        out << (i ? ", " : "") << stats.threadBusySeconds[i];
+    }
+    out << "]\n}\n";
+    return bool(out);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Counters for one thread's share of rendering work. Each thread updates its
+// own block without synchronization; blocks are summed once rendering is done.
+struct RenderStats {
+    uint64_t primaryRays = 0;
+    uint64_t shadowRays = 0;
+    uint64_t reflectionRays = 0;
+    uint64_t probeRays = 0;      // tile-planning probes and the rays they spawned; not in totalRays()
+    uint64_t sphereTests = 0;
+    uint64_t planeTests = 0;
+    uint64_t cubeTests = 0;
+    uint64_t triangleTests = 0;
+    uint64_t hits = 0;           // rays that hit any primitive
+    uint64_t cutoffPaths = 0;    // reflections skipped below the minimum contribution
+    uint64_t roulettePaths = 0;  // reflections ended by Russian roulette
+    int maxDepth = 0;            // deepest bounce shaded (1 = primary hit)
+    double busySeconds = 0.0;    // time spent inside render loops
+
+    uint64_t totalRays() const { return primaryRays + shadowRays + reflectionRays; }
+    uint64_t totalTests() const { return sphereTests + planeTests + cubeTests + triangleTests; }
+    void merge(const RenderStats& other);
+};
+
+// Allocates and registers a block for the calling thread; blocks outlive
+// their threads so results from finished threads are kept.
+RenderStats* register_thread_stats();
+
+inline RenderStats& thread_render_stats() {
+    thread_local RenderStats* stats = nullptr;
+    if (!stats) stats = register_thread_stats();
+    return *stats;
+}
+
+struct StatsSnapshot {
+    RenderStats total;
+    std::vector<double> threadBusySeconds;   // threads that did any work
+};
+
+// Only meaningful while no render is running.
+StatsSnapshot collect_render_stats();
+void reset_render_stats();
+
+// Adds the lifetime of the scope to the calling thread's busy time.
+class ScopedBusyTime {
+public:
+    ScopedBusyTime() : start(std::chrono::steady_clock::now()) {}
+    ~ScopedBusyTime() {
+        thread_render_stats().busySeconds +=
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+struct StatsReportInfo {
+    std::string scene;
+    int width = 0, height = 0;
+    int samplesPerPixel = 1;
+    uint32_t seed = 0;
+    std::string sampler = "stratified";
+    std::string kernels = "generic";
+    std::string features;   // tracer variant, see scene_features_name
+    int threads = 1;
+    int frames = 1;
+    double loadSeconds = 0.0, renderSeconds = 0.0, saveSeconds = 0.0;
+};
+
+bool write_stats_json(const std::string& filename, const StatsReportInfo& info, const StatsSnapshot& stats);
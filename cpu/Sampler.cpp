@@ -0,0 +1,200 @@
+#include "Sampler.h"
+#include "Random.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+bool parse_sampler_type(const std::string& name, SamplerType& type) {
+    if (name == "independent") type = SamplerType::Independent;
+    else if (name == "stratified") type = SamplerType::Stratified;
+    else if (name == "sobol") type = SamplerType::Sobol;
+    else if (name == "bluenoise") type = SamplerType::BlueNoise;
+    else return false;
+    return true;
+}
+
+const char* sampler_type_name(SamplerType type) {
+    switch (type) {
+    case SamplerType::Independent: return "independent";
+    case SamplerType::Stratified: return "stratified";
+    case SamplerType::Sobol: return "sobol";
+    case SamplerType::BlueNoise: return "bluenoise";
+    }
+    return "unknown";
+}
+
+static uint32_t reverse_bits(uint32_t x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    x = ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+    return x;
+}
+
+// Owen scrambling by hashing (Burley, "Practical Hash-based Owen Scrambling"):
+// every bit is flipped depending only on the more significant bits.
+static uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed) {
+    x = reverse_bits(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverse_bits(x);
+}
+
+// First two Sobol dimensions (van der Corput and x + 1), which together form
+// a (0,2)-sequence: every power-of-two prefix is stratified in 2D.
+static uint32_t sobol(uint32_t index, uint32_t dimension) {
+    static const std::array<uint32_t, 32> directions = [] {
+        std::array<uint32_t, 32> v{};
+        uint32_t m = 1;
+        for (int k = 1; k <= 32; ++k) {
+            if (k > 1) m = (m << 1) ^ m;
+            v[k - 1] = m << (32 - k);
+        }
+        return v;
+    }();
+    if (dimension == 0) return reverse_bits(index);
+    uint32_t x = 0;
+    for (int bit = 0; index; index >>= 1, ++bit) {
+        if (index & 1) x ^= directions[bit];
+    }
+    return x;
+}
+
+static uint32_t pair_index(uint32_t bounce, uint32_t dimension) {
+    return (bounce * SAMPLE_DIMENSIONS_PER_BOUNCE + dimension) / 2;
+}
+
+namespace {
+
+class IndependentSampler : public Sampler {
+public:
+    using Sampler::Sampler;
+    float get(int x, int y, uint32_t index, uint32_t bounce, uint32_t dimension) const override {
+        return SampleRng(seed, frame, uint32_t(y * width + x), index).uniform(bounce, dimension);
+    }
+};
+
+// The grid has exactly samplesPerPixel cells, columns x rows with the two
+// as close to square as its divisors allow, so every cell gets one sample.
+// Pixel positions use cell `index`; other pairs start at a per-pixel offset
+// into the grid so their strata are not correlated.
+class StratifiedSampler : public Sampler {
+public:
+    StratifiedSampler(int width, int samplesPerPixel, uint32_t seed, uint32_t frame)
+        : Sampler(width, samplesPerPixel, seed, frame) {
+        int cells = std::max(1, samplesPerPixel);
+        rows = 1;
+        for (int d = 1; d * d <= cells; ++d) {
+            if (cells % d == 0) rows = d;
+        }
+        columns = cells / rows;
+    }
+
+    float get(int x, int y, uint32_t index, uint32_t bounce, uint32_t dimension) const override {
+        uint32_t pixel = uint32_t(y * width + x);
+        uint32_t pair = pair_index(bounce, dimension);
+        if (pair > 0) {
+            index += SampleRng(seed, frame, pixel, 0).nextUint(bounce, dimension & ~1u) % uint32_t(columns * rows);
+        }
+        float jitter = SampleRng(seed, frame, pixel, index).uniform(bounce, dimension);
+        if (dimension & 1) return (float(index / columns % rows) + jitter) / rows;
+        return (float(index % columns) + jitter) / columns;
+    }
+
+private:
+    int columns, rows;
+};
+
+class SobolSampler : public Sampler {
+public:
+    using Sampler::Sampler;
+    float get(int x, int y, uint32_t index, uint32_t bounce, uint32_t dimension) const override {
+        SampleRng rng(seed, frame, uint32_t(y * width + x), 0);
+        uint32_t shuffled = nested_uniform_scramble(index, rng.nextUint(bounce, dimension & ~1u));
+        uint32_t v = sobol(shuffled, dimension & 1);
+        return uint_to_unit_float(nested_uniform_scramble(v, rng.nextUint(bounce, 32 + dimension)));
+    }
+};
+
+static const int MASK_SIZE = 64;
+
+// Ranks of a tileable 64x64 blue-noise mask, grown by repeatedly placing the
+// next point in the largest void (lowest Gaussian energy) of the points so far.
+static const std::vector<uint16_t>& blue_noise_mask() {
+    static const std::vector<uint16_t> mask = [] {
+        const int n = MASK_SIZE * MASK_SIZE;
+        const int radius = 6;
+        std::vector<float> kernel;
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                kernel.push_back(std::exp(-float(dx * dx + dy * dy) / (2.0f * 1.5f * 1.5f)));
+            }
+        }
+
+        std::vector<float> energy(n);
+        for (int i = 0; i < n; ++i) energy[i] = uint_to_unit_float(pcg_hash(uint32_t(i))) * 1e-3f;
+        std::vector<uint16_t> rank(n);
+        std::vector<unsigned char> placed(n, 0);
+        for (int r = 0; r < n; ++r) {
+            int best = -1;
+            for (int i = 0; i < n; ++i) {
+                if (!placed[i] && (best < 0 || energy[i] < energy[best])) best = i;
+            }
+            placed[best] = 1;
+            rank[best] = uint16_t(r);
+            int bx = best % MASK_SIZE, by = best / MASK_SIZE;
+            const float* k = kernel.data();
+            for (int dy = -radius; dy <= radius; ++dy) {
+                int row = ((by + dy) & (MASK_SIZE - 1)) * MASK_SIZE;
+                for (int dx = -radius; dx <= radius; ++dx) {
+                    energy[row + ((bx + dx) & (MASK_SIZE - 1))] += *k++;
+                }
+            }
+        }
+        return rank;
+    }();
+    return mask;
+}
+
+// Every pixel shares one scrambled Sobol sequence, rotated (Cranley-Patterson)
+// by the mask value under it: per-pixel error becomes high-frequency noise
+// that is much less visible, and averages out under any blur or denoiser.
+class BlueNoiseSampler : public Sampler {
+public:
+    BlueNoiseSampler(int width, int samplesPerPixel, uint32_t seed, uint32_t frame)
+        : Sampler(width, samplesPerPixel, seed, frame), mask(blue_noise_mask()) {}
+
+    float get(int x, int y, uint32_t index, uint32_t bounce, uint32_t dimension) const override {
+        SampleRng rng(seed, frame, 0, 0);
+        uint32_t shuffled = nested_uniform_scramble(index, rng.nextUint(bounce, dimension & ~1u));
+        uint32_t v = nested_uniform_scramble(sobol(shuffled, dimension & 1), rng.nextUint(bounce, 32 + dimension));
+
+        // Each dimension reads the mask at its own toroidal offset
+        uint32_t offset = rng.nextUint(bounce, 16 + dimension);
+        int mx = (x + int(offset & 0xffff)) & (MASK_SIZE - 1);
+        int my = (y + int(offset >> 16)) & (MASK_SIZE - 1);
+        uint32_t rotation = (uint32_t(mask[my * MASK_SIZE + mx]) << 20) | (1u << 19);
+        return uint_to_unit_float(v + rotation);
+    }
+
+private:
+    const std::vector<uint16_t>& mask;
+};
+
+}
+
+std::unique_ptr<Sampler> make_sampler(SamplerType type, int width, int samplesPerPixel, uint32_t seed,
+                                      uint32_t frame) {
+    switch (type) {
+    case SamplerType::Independent: return std::make_unique<IndependentSampler>(width, samplesPerPixel, seed, frame);
+    case SamplerType::Sobol: return std::make_unique<SobolSampler>(width, samplesPerPixel, seed, frame);
+    case SamplerType::BlueNoise: return std::make_unique<BlueNoiseSampler>(width, samplesPerPixel, seed, frame);
+    case SamplerType::Stratified: break;
+    }
+    return std::make_unique<StratifiedSampler>(width, samplesPerPixel, seed, frame);
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Sample streams for multi-sample renders. A sampler maps (pixel, sample
+// index, bounce, dimension) to a value in [0, 1); like SampleRng it keeps no
+// state, so any thread can evaluate any sample in any order.
+
+enum class SamplerType : uint32_t {
+    Independent = 0,   // uncorrelated hash per dimension
+    Stratified = 1,    // jittered grid of spp cells per dimension pair
+    Sobol = 2,         // Owen-scrambled Sobol (0,2)-sequence per dimension pair
+    BlueNoise = 3,     // one Sobol sequence, offset per pixel by a blue-noise mask
+};
+
+bool parse_sampler_type(const std::string& name, SamplerType& type);
+const char* sampler_type_name(SamplerType type);
+
+// Dimensions within one bounce; pairs (0,1), (2,3), ... are sampled jointly.
+// Every bounce has its own block, so a decision added at one depth does not
+// shift the numbers drawn at another.
+enum SampleDimension : uint32_t {
+    SAMPLE_PIXEL_X = 0,
+    SAMPLE_PIXEL_Y = 1,
+    SAMPLE_LIGHT_SELECT = 2,
+    SAMPLE_ROULETTE = 3,
+    SAMPLE_LIGHT_U = 4,
+    SAMPLE_LIGHT_V = 5,
+    SAMPLE_REFLECT_U = 6,
+    SAMPLE_REFLECT_V = 7,
+    SAMPLE_DIMENSIONS_PER_BOUNCE = 8,
+};
+
+class Sampler {
+public:
+    Sampler(int width, int samplesPerPixel, uint32_t seed, uint32_t frame)
+        : width(width), samplesPerPixel(samplesPerPixel), seed(seed), frame(frame) {}
+    virtual ~Sampler() = default;
+
+    virtual float get(int x, int y, uint32_t index, uint32_t bounce, uint32_t dimension) const = 0;
+
+protected:
+    int width;
+    int samplesPerPixel;
+    uint32_t seed, frame;
+};
+
+std::unique_ptr<Sampler> make_sampler(SamplerType type, int width, int samplesPerPixel, uint32_t seed,
+                                      uint32_t frame);
@@ -0,0 +1,33 @@
+#include "SceneFeatures.h"
+
+static unsigned material_features(const Material& mat) {
+    unsigned features = 0;
+    if (mat.reflectivity > 0.0f) features |= FEATURE_REFLECTION;
+    if (mat.emission.x != 0.0f || mat.emission.y != 0.0f || mat.emission.z != 0.0f) features |= FEATURE_EMISSION;
+    return features;
+}
+
+unsigned scene_features(const Scene& scene) {
+    unsigned features = 0;
+    if (!scene.spheres.empty()) features |= FEATURE_SPHERES;
+    if (!scene.planes.empty()) features |= FEATURE_PLANES;
+    if (!scene.cubes.empty()) features |= FEATURE_CUBES;
+    if (!scene.triangles.empty()) features |= FEATURE_TRIANGLES;
+    for (const auto& s : scene.spheres) features |= material_features(s.material);
+    for (const auto& p : scene.planes) features |= material_features(p.material);
+    for (const auto& c : scene.cubes) features |= material_features(c.material);
+    for (const auto& t : scene.triangles) features |= material_features(t.material);
+    if (!scene.lights.empty()) features |= FEATURE_LIGHTS;
+    if (scene.lights.size() > 1) features |= FEATURE_MANY_LIGHTS;
+    return features;
+}
+
+std::string scene_features_name(unsigned features) {
+    static const char* names[] = {"spheres", "planes", "cubes", "triangles",
+                                  "reflection", "emission", "lights", "many-lights"};
+    std::string result;
+    for (unsigned bit = 0; bit < sizeof(names) / sizeof(names[0]); ++bit) {
+        if (features & (1u << bit)) result += (result.empty() ? "" : " ") + std::string(names[bit]);
+    }
+    return result.empty() ? "none" : result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <string>
+#include "../loader/SceneLoader.h"
+
+// What a scene actually uses, as a bitmask of SceneFeature flags. The tracer
+// is compiled once per mask and picks the matching variant per render, so
+// empty primitive loops and unused shading terms drop out of the hot path.
+enum SceneFeature : unsigned {
+    FEATURE_SPHERES     = 1 << 0,
+    FEATURE_PLANES      = 1 << 1,
+    FEATURE_CUBES       = 1 << 2,
+    FEATURE_TRIANGLES   = 1 << 3,
+    FEATURE_REFLECTION  = 1 << 4,   // some material has reflectivity > 0
+    FEATURE_EMISSION    = 1 << 5,   // some material has non-zero emission
+    FEATURE_LIGHTS      = 1 << 6,   // at least one point light
+    FEATURE_MANY_LIGHTS = 1 << 7,   // more than one; only set with FEATURE_LIGHTS
+    FEATURE_ALL         = (1 << 8) - 1,
+    FEATURE_MASK_COUNT  = 1 << 8,
+};
+unsigned scene_features(const Scene& scene);
+// Space-separated flag names, e.g. "spheres planes lights"; "none" for 0.
+std::string scene_features_name(unsigned features);
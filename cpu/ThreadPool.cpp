@@ -0,0 +1,78 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+
+ThreadPool::ThreadPool(int threads) {
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; ++i) {
+        workers.emplace_back([this] {
+            Task task;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+                    if (tasks.empty()) return;
+                    task = tasks.top();
+                    tasks.pop();
+                }
+                task.fn();
+            }
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void ThreadPool::submit(std::function<void()> task, int priority) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push(Task{priority, nextSeq++, std::move(task)});
+    }
+    cv.notify_one();
+}
+
+bool ThreadPool::popTask(Task& task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tasks.empty()) return false;
+    task = tasks.top();
+    tasks.pop();
+    return true;
+}
+
+bool ThreadPool::runOne() {
+    Task task;
+    if (!popTask(task)) return false;
+    task.fn();
+    return true;
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++pending;
+    }
+    pool.submit([this, task = std::move(task)] {
+        task();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--pending == 0) done.notify_all();
+    }, priority);
+}
+
+void TaskGroup::wait() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (pending == 0) return;
+        }
+        if (pool.runOne()) continue;
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait_for(lock, std::chrono::milliseconds(5), [this] { return pending == 0; });
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads running queued tasks, highest priority first
+// (FIFO among equal priorities).
+class ThreadPool {
+public:
+    // threads <= 0 uses the hardware concurrency
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task, int priority = 0);
+    // Runs one queued task on the calling thread; false if the queue was empty.
+    bool runOne();
+    int size() const { return int(workers.size()); }
+
+private:
+    struct Task {
+        int priority;
+        uint64_t seq;
+        std::function<void()> fn;
+        bool operator<(const Task& o) const {
+            return priority != o.priority ? priority < o.priority : seq > o.seq;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    std::priority_queue<Task> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t nextSeq = 0;
+    bool stopping = false;
+
+    bool popTask(Task& task);
+};
+
+// Tracks a batch of tasks so the submitter can wait for all of them. The
+// waiting thread helps run queued work, so waiting from inside a pool task
+// cannot deadlock.
+class TaskGroup {
+public:
+    explicit TaskGroup(ThreadPool& pool, int priority = 0) : pool(pool), priority(priority) {}
+    ~TaskGroup() { wait(); }
+
+    void run(std::function<void()> task);
+    void wait();
+
+private:
+    ThreadPool& pool;
+    int priority;
+    std::mutex mutex;
+    std::condition_variable done;
+    int pending = 0;
+};
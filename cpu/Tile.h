@@ -0,0 +1,28 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+// Half-open pixel rectangle [x0, x1) x [y0, y1).
+struct Tile {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+    int area() const { return width() * height(); }
+};
+
+// Row-major grid of tiles covering region.
+inline std::vector<Tile> make_tiles(const Tile& region, int tileSize) {
+    std::vector<Tile> tiles;
+    tileSize = std::max(1, tileSize);
+    for (int y = region.y0; y < region.y1; y += tileSize) {
+        for (int x = region.x0; x < region.x1; x += tileSize) {
+            tiles.push_back({x, y, std::min(x + tileSize, region.x1), std::min(y + tileSize, region.y1)});
+        }
+    }
+    return tiles;
+}
+
+inline std::vector<Tile> make_tiles(int width, int height, int tileSize) {
+    return make_tiles(Tile{0, 0, width, height}, tileSize);
+}
@@ -0,0 +1,65 @@
+#include "TilePlanner.h"
+#include <algorithm>
+#include <numeric>
+
+void CostEstimate::reset(const Tile& r, int s) {
+    region = r;
+    step = std::max(1, s);
+    columns = (r.width() + step - 1) / step;
+    rows = (r.height() + step - 1) / step;
+    cost.assign(size_t(columns) * rows, 0.0f);
+}
+
+double CostEstimate::estimate(const Tile& tile) const {
+    double sum = 0.0;
+    int c0 = (tile.x0 - region.x0) / step, c1 = (tile.x1 - region.x0 + step - 1) / step;
+    int r0 = (tile.y0 - region.y0) / step, r1 = (tile.y1 - region.y0 + step - 1) / step;
+    for (int r = std::max(0, r0); r < std::min(rows, r1); ++r) {
+        int by0 = region.y0 + r * step, by1 = std::min(by0 + step, region.y1);
+        int oy = std::min(tile.y1, by1) - std::max(tile.y0, by0);
+        for (int c = std::max(0, c0); c < std::min(columns, c1); ++c) {
+            int bx0 = region.x0 + c * step, bx1 = std::min(bx0 + step, region.x1);
+            int ox = std::min(tile.x1, bx1) - std::max(tile.x0, bx0);
+            double fraction = double(ox) * oy / (double(bx1 - bx0) * (by1 - by0));
+            sum += cost[size_t(r) * columns + c] * fraction;
+        }
+    }
+    return sum;
+}
+
+double CostEstimate::total() const {
+    return std::accumulate(cost.begin(), cost.end(), 0.0);
+}
+
+std::vector<Tile> plan_tiles(const Tile& region, const CostEstimate& estimate, int targetTiles,
+                             int minSize, int maxSize) {
+    double budget = estimate.total() / std::max(1, targetTiles);
+    std::vector<std::pair<double, Tile>> planned;
+    std::vector<Tile> pending = make_tiles(region, maxSize);
+    while (!pending.empty()) {
+        Tile tile = pending.back();
+        pending.pop_back();
+        double cost = estimate.estimate(tile);
+        bool splitX = tile.width() >= tile.height();
+        int extent = splitX ? tile.width() : tile.height();
+        if (cost > budget && extent / 2 >= minSize) {
+            Tile a = tile, b = tile;
+            if (splitX) a.x1 = b.x0 = tile.x0 + extent / 2;
+            else a.y1 = b.y0 = tile.y0 + extent / 2;
+            pending.push_back(a);
+            pending.push_back(b);
+        } else {
+            planned.push_back({cost, tile});
+        }
+    }
+
+    // Ties in scan order, so the plan is deterministic
+    std::sort(planned.begin(), planned.end(), [](const auto& a, const auto& b) {
+        if (a.first != b.first) return a.first > b.first;
+        return a.second.y0 != b.second.y0 ? a.second.y0 < b.second.y0 : a.second.x0 < b.second.x0;
+    });
+    std::vector<Tile> tiles;
+    tiles.reserve(planned.size());
+    for (const auto& p : planned) tiles.push_back(p.second);
+    return tiles;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <vector>
+#include "Tile.h"
+
+// Coarse per-region cost estimate: one value per step x step pixel block,
+// from a probe pass that traces one ray per block.
+struct CostEstimate {
+    Tile region;
+    int step = 8;
+    int columns = 0, rows = 0;
+    std::vector<float> cost;
+
+    void reset(const Tile& region, int step);
+    float& at(int column, int row) { return cost[size_t(row) * columns + column]; }
+    // Estimated cost of tile, blocks weighted by how much of them it covers
+    double estimate(const Tile& tile) const;
+    double total() const;
+};
+
+// Splits region into tiles of roughly equal estimated cost, most expensive
+// first: tiles start at maxSize and are halved along their longer side
+// while they cost more than 1/targetTiles of the frame and stay >= minSize.
+std::vector<Tile> plan_tiles(const Tile& region, const CostEstimate& estimate, int targetTiles,
+                             int minSize, int maxSize);
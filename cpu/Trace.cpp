@@ -0,0 +1,112 @@
+#include "Trace.h"
+#include <iostream>
+
+#if BEAMLINE_TRACING
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> g_traceEnabled{false};
+
+struct TraceEvent {
+    const char* category;
+    const char* name;
+    double start, end;   // microseconds since trace_start
+    std::string args;
+};
+
+struct ThreadTrace {
+    int tid;
+    std::thread::id thread;
+    std::vector<TraceEvent> events;
+};
+
+static std::mutex g_traceMutex;
+static std::vector<std::unique_ptr<ThreadTrace>> g_threadTraces;
+static std::chrono::steady_clock::time_point g_traceEpoch;
+static std::string g_traceFile;
+static std::thread::id g_traceMainThread;
+
+static ThreadTrace* register_thread_trace() {
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    auto trace = std::make_unique<ThreadTrace>();
+    trace->tid = int(g_threadTraces.size()) + 1;
+    trace->thread = std::this_thread::get_id();
+    g_threadTraces.push_back(std::move(trace));
+    return g_threadTraces.back().get();
+}
+
+double trace_now_us() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - g_traceEpoch).count();
+}
+
+void trace_record(const char* category, const char* name, double startUs, double endUs, std::string args) {
+    thread_local ThreadTrace* local = nullptr;
+    if (!local) local = register_thread_trace();
+    local->events.push_back({category, name, startUs, endUs, std::move(args)});
+}
+
+std::string trace_args(std::initializer_list<std::pair<const char*, long long>> args) {
+    std::string out = "{";
+    for (const auto& arg : args) {
+        if (out.size() > 1) out += ",";
+        out += "\"" + std::string(arg.first) + "\":" + std::to_string(arg.second);
+    }
+    return out + "}";
+}
+
+bool trace_start(const std::string& filename) {
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    for (auto& trace : g_threadTraces) trace->events.clear();
+    g_traceFile = filename;
+    g_traceEpoch = std::chrono::steady_clock::now();
+    g_traceMainThread = std::this_thread::get_id();
+    g_traceEnabled = true;
+    return true;
+}
+
+// Complete ("X") events plus thread-name metadata; pid is always 1
+bool trace_stop() {
+    if (!g_traceEnabled.exchange(false)) return false;
+    std::lock_guard<std::mutex> lock(g_traceMutex);
+    std::ofstream out(g_traceFile);
+    if (!out) {
+        std::cerr << "[ERROR] Couldn't open file: " << g_traceFile << "\n";
+        return false;
+    }
+
+    char number[64];
+    size_t count = 0;
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    for (const auto& trace : g_threadTraces) {
+        std::string thread_name = trace->thread == g_traceMainThread ? "main" : "worker " + std::to_string(trace->tid);
+        out << (count++ ? ",\n" : "") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << trace->tid
+            << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << thread_name << "\"}}";
+        for (const TraceEvent& e : trace->events) {
+            std::snprintf(number, sizeof(number), "\"ts\":%.3f,\"dur\":%.3f", e.start, e.end - e.start);
+            out << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << trace->tid << ",\"cat\":\"" << e.category
+                << "\",\"name\":\"" << e.name << "\"," << number;
+            if (!e.args.empty()) out << ",\"args\":" << e.args;
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    return bool(out);
+}
+
+#else
+
+bool trace_start(const std::string&) {
+    std::cerr << "[WARNING] Built without tracing (BEAMLINE_ENABLE_TRACE=OFF); --trace ignored.\n";
+    return false;
+}
+
+bool trace_stop() {
+    return false;
+}
+
+#endif
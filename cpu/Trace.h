@@ -0,0 +1,69 @@
+#pragma once
+#include <initializer_list>
+#include <string>
+#include <utility>
+
+// Timeline instrumentation written as Chrome trace-event JSON (open in
+// chrome://tracing or ui.perfetto.dev). Scopes record nothing unless a trace
+// was started, and compile to nothing when BEAMLINE_TRACING is 0
+// (cmake -DBEAMLINE_ENABLE_TRACE=OFF).
+//
+//   TRACE_SCOPE("image", "encode");
+//   TRACE_SCOPE_ARGS("render", "tile", {"x0", tile.x0}, {"y0", tile.y0});
+
+#ifndef BEAMLINE_TRACING
+#define BEAMLINE_TRACING 1
+#endif
+
+// Events are buffered per thread and written by trace_stop(). False (with a
+// warning) when tracing was compiled out.
+bool trace_start(const std::string& filename);
+bool trace_stop();
+
+#if BEAMLINE_TRACING
+#include <atomic>
+
+extern std::atomic<bool> g_traceEnabled;
+
+inline bool trace_enabled() {
+    return g_traceEnabled.load(std::memory_order_relaxed);
+}
+
+double trace_now_us();
+void trace_record(const char* category, const char* name, double startUs, double endUs, std::string args);
+std::string trace_args(std::initializer_list<std::pair<const char*, long long>> args);
+
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : category(category), name(name), start(trace_enabled() ? trace_now_us() : -1.0) {}
+
+    // argsFn only runs while recording
+    template <class ArgsFn>
+    TraceScope(const char* category, const char* name, ArgsFn argsFn) : TraceScope(category, name) {
+        if (start >= 0.0) args = argsFn();
+    }
+
+    ~TraceScope() {
+        if (start >= 0.0) trace_record(category, name, start, trace_now_us(), std::move(args));
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category;
+    const char* name;
+    double start;
+    std::string args;
+};
+
+#define BEAMLINE_TRACE_CONCAT_(a, b) a##b
+#define BEAMLINE_TRACE_CONCAT(a, b) BEAMLINE_TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(category, name) TraceScope BEAMLINE_TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+#define TRACE_SCOPE_ARGS(category, name, ...) \
+    TraceScope BEAMLINE_TRACE_CONCAT(traceScope_, __LINE__)(category, name, [&] { return trace_args({__VA_ARGS__}); })
+#else
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_SCOPE_ARGS(category, name, ...) ((void)0)
+#endif
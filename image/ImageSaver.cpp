@@ -2,16 +2,20 @@
 #include "stb_image_write.h"
 
 #include "ImageSaver.h"
+#include "../cpu/Trace.h"
+#include "../cpu/Kernels.h"
+#include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <cctype>
 #include <algorithm>
 
-static void save_ppm(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height) {
+static bool save_ppm(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height) {
+    TRACE_SCOPE("image", "write_ppm");
     std::ofstream ofs(filename);
     if (!ofs) {
         std::cerr << "[ERROR] Couldn't open file: " << filename << "\n";
-        return;
+        return false;
     }
 
     ofs << "P3\n" << width << " " << height << "\n255\n";
@@ -24,34 +28,82 @@ static void save_ppm(const std::string& filename, const std::vector<Vec3>& frame
             ofs << r << ' ' << g << ' ' << b << '\n';
         }
     }
+    ofs.close();
+    if (!ofs) {
+        std::cerr << "[ERROR] Failed to write PPM image: " << filename << "\n";
+        return false;
+    }
 
     std::cout << "[OK] Saved PPM image: " << filename << "\n";
+    return true;
 }
 
-static void save_png(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height) {
+static std::vector<unsigned char> quantize_rgb8(const std::vector<Vec3>& framebuffer, int width, int height) {
+    TRACE_SCOPE("image", "quantize");
     std::vector<unsigned char> image(3 * width * height);
-    for (int i = 0; i < width * height; ++i) {
-        image[3 * i + 0] = static_cast<unsigned char>(255.999f * std::clamp(framebuffer[i].x, 0.0f, 1.0f));
-        image[3 * i + 1] = static_cast<unsigned char>(255.999f * std::clamp(framebuffer[i].y, 0.0f, 1.0f));
-        image[3 * i + 2] = static_cast<unsigned char>(255.999f * std::clamp(framebuffer[i].z, 0.0f, 1.0f));
+    active_kernels().quantizeRgb8(framebuffer.data(), size_t(width) * height, image.data());
+    return image;
+}
+
+static bool save_png(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height) {
+    std::vector<unsigned char> png;
+    if (!encode_image("png", framebuffer, width, height, png)) {
+        std::cerr << "[ERROR] Failed to save PNG image.\n";
+        return false;
     }
 
-    if (stbi_write_png(filename.c_str(), width, height, 3, image.data(), width * 3)) {
+    TRACE_SCOPE("image", "write");
+    FILE* f = std::fopen(filename.c_str(), "wb");
+    bool ok = f && std::fwrite(png.data(), 1, png.size(), f) == png.size();
+    if (f && std::fclose(f) != 0) ok = false;
+    if (ok) {
         std::cout << "[OK] Saved PNG image: " << filename << "\n";
     } else {
         std::cerr << "[ERROR] Failed to save PNG image.\n";
     }
+    return ok;
 }
 
-void save_image(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height) {
+bool save_image(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height) {
     std::string ext = filename.substr(filename.find_last_of('.') + 1);
     for (auto& c : ext) c = std::tolower(c);
 
-    if (ext == "ppm") {
-        save_ppm(filename, framebuffer, width, height);
-    } else if (ext == "png") {
-        save_png(filename, framebuffer, width, height);
-    } else {
-        std::cerr << "[ERROR] Unsupported format: ." << ext << "\n";
+    if (ext == "ppm") return save_ppm(filename, framebuffer, width, height);
+    if (ext == "png") return save_png(filename, framebuffer, width, height);
+    std::cerr << "[ERROR] Unsupported format: ." << ext << "\n";
+    return false;
+}
+
+static void append_to_vector(void* context, void* data, int size) {
+    auto* out = static_cast<std::vector<unsigned char>*>(context);
+    auto* bytes = static_cast<unsigned char*>(data);
+    out->insert(out->end(), bytes, bytes + size);
+}
+
+bool encode_image(const std::string& format, const std::vector<Vec3>& framebuffer, int width, int height,
+                  std::vector<unsigned char>& out) {
+    out.clear();
+    if (format == "png") {
+        std::vector<unsigned char> image = quantize_rgb8(framebuffer, width, height);
+        TRACE_SCOPE("image", "encode_png");
+        return stbi_write_png_to_func(append_to_vector, &out, width, height, 3, image.data(), width * 3) != 0;
+    }
+    if (format == "ppm") {
+        std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+        out.assign(header.begin(), header.end());
+        std::vector<unsigned char> image = quantize_rgb8(framebuffer, width, height);
+        out.insert(out.end(), image.begin(), image.end());
+        return true;
+    }
+    if (format == "raw") {
+        out.resize(size_t(width) * height * 3 * sizeof(float));
+        float* dst = reinterpret_cast<float*>(out.data());
+        for (size_t i = 0; i < size_t(width) * height; ++i) {
+            dst[3 * i + 0] = framebuffer[i].x;
+            dst[3 * i + 1] = framebuffer[i].y;
+            dst[3 * i + 2] = framebuffer[i].z;
+        }
+        return true;
     }
+    return false;
 }
\ No newline at end of file
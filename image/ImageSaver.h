@@ -3,4 +3,11 @@
 #include <vector>
 #include "../Vec3.h"
 
-void save_image(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height);
+// Format from the extension (.ppm or .png); false after printing an error.
+bool save_image(const std::string& filename, const std::vector<Vec3>& framebuffer, int width, int height);
+
+
+// Encodes into memory instead of a file. format is "png", "ppm" (binary P6)
+// or "raw" (float32 RGB triples, row-major). False for unknown formats.
+bool encode_image(const std::string& format, const std::vector<Vec3>& framebuffer, int width, int height,
+                  std::vector<unsigned char>& out);
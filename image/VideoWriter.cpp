@@ -0,0 +1,180 @@
+#include "VideoWriter.h"
+#include "../cpu/Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BEAMLINE_YUV_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// BT.601 coefficients, scaled to video range (Y: 16-235, UV: 16-240)
+static const float KY_R = 219.0f * 0.299f;
+static const float KY_G = 219.0f * 0.587f;
+static const float KY_B = 219.0f * 0.114f;
+static const float KU_R = 224.0f * -0.168736f;
+static const float KU_G = 224.0f * -0.331264f;
+static const float KU_B = 224.0f * 0.5f;
+static const float KV_R = 224.0f * 0.5f;
+static const float KV_G = 224.0f * -0.418688f;
+static const float KV_B = 224.0f * -0.081312f;
+
+bool is_y4m_output(const std::string& filename) {
+    if (filename == "-") return true;
+    size_t dot = filename.find_last_of('.');
+    if (dot == std::string::npos) return false;
+    std::string ext = filename.substr(dot + 1);
+    for (auto& c : ext) c = std::tolower(c);
+    return ext == "y4m";
+}
+
+static inline unsigned char to_byte(float v) {
+    return static_cast<unsigned char>(std::nearbyint(std::clamp(v, 0.0f, 255.0f)));
+}
+
+static inline float clamp01(float v) {
+    return std::clamp(v, 0.0f, 1.0f);
+}
+
+#ifdef BEAMLINE_YUV_SSE2
+static inline __m128 load_clamped(const float* p) {
+    return _mm_min_ps(_mm_max_ps(_mm_loadu_ps(p), _mm_setzero_ps()), _mm_set1_ps(1.0f));
+}
+
+static inline void store_bytes4(unsigned char* dst, __m128 v) {
+    __m128i i = _mm_cvtps_epi32(v);
+    i = _mm_packs_epi32(i, i);
+    i = _mm_packus_epi16(i, i);
+    int packed = _mm_cvtsi128_si32(i);
+    std::memcpy(dst, &packed, 4);
+}
+#endif
+
+void rgb_to_luma_row(const float* r, const float* g, const float* b, unsigned char* y, int n) {
+    int i = 0;
+#ifdef BEAMLINE_YUV_SSE2
+    const __m128 kr = _mm_set1_ps(KY_R), kg = _mm_set1_ps(KY_G), kb = _mm_set1_ps(KY_B);
+    const __m128 off = _mm_set1_ps(16.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 R = load_clamped(r + i), G = load_clamped(g + i), B = load_clamped(b + i);
+        __m128 Y = _mm_add_ps(off, _mm_add_ps(_mm_mul_ps(kr, R), _mm_add_ps(_mm_mul_ps(kg, G), _mm_mul_ps(kb, B))));
+        store_bytes4(y + i, Y);
+    }
+#endif
+    for (; i < n; ++i) {
+        float R = clamp01(r[i]), G = clamp01(g[i]), B = clamp01(b[i]);
+        y[i] = to_byte(16.0f + KY_R * R + KY_G * G + KY_B * B);
+    }
+}
+
+void rgb_to_chroma_row(const float* r, const float* g, const float* b, unsigned char* u, unsigned char* v, int n) {
+    int i = 0;
+#ifdef BEAMLINE_YUV_SSE2
+    const __m128 ur = _mm_set1_ps(KU_R), ug = _mm_set1_ps(KU_G), ub = _mm_set1_ps(KU_B);
+    const __m128 vr = _mm_set1_ps(KV_R), vg = _mm_set1_ps(KV_G), vb = _mm_set1_ps(KV_B);
+    const __m128 off = _mm_set1_ps(128.0f);
+    for (; i + 4 <= n; i += 4) {
+        __m128 R = load_clamped(r + i), G = load_clamped(g + i), B = load_clamped(b + i);
+        __m128 U = _mm_add_ps(off, _mm_add_ps(_mm_mul_ps(ur, R), _mm_add_ps(_mm_mul_ps(ug, G), _mm_mul_ps(ub, B))));
+        __m128 V = _mm_add_ps(off, _mm_add_ps(_mm_mul_ps(vr, R), _mm_add_ps(_mm_mul_ps(vg, G), _mm_mul_ps(vb, B))));
+        store_bytes4(u + i, U);
+        store_bytes4(v + i, V);
+    }
+#endif
+    for (; i < n; ++i) {
+        float R = clamp01(r[i]), G = clamp01(g[i]), B = clamp01(b[i]);
+        u[i] = to_byte(128.0f + KU_R * R + KU_G * G + KU_B * B);
+        v[i] = to_byte(128.0f + KV_R * R + KV_G * G + KV_B * B);
+    }
+}
+
+Y4MWriter::~Y4MWriter() {
+    close();
+}
+
+bool Y4MWriter::open(const std::string& path, int w, int h, int fps) {
+    close();
+    if (path == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        out = stdout;
+        owns_file = false;
+    } else {
+        out = std::fopen(path.c_str(), "wb");
+        owns_file = true;
+        if (!out) {
+            std::cerr << "[ERROR] Couldn't open file: " << path << "\n";
+            return false;
+        }
+    }
+
+    width = w;
+    height = h;
+    int cw = (w + 1) / 2, ch = (h + 1) / 2;
+    frame.assign(size_t(w) * h + 2 * size_t(cw) * ch, 0);
+    rows.assign(3 * size_t(w), 0.0f);
+
+    std::fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", w, h, fps);
+    return !std::ferror(out);
+}
+
+bool Y4MWriter::write_frame(const std::vector<Vec3>& framebuffer) {
+    if (!out) return false;
+    TRACE_SCOPE("image", "y4m_frame");
+
+    int cw = (width + 1) / 2, ch = (height + 1) / 2;
+    unsigned char* Y = frame.data();
+    unsigned char* U = Y + size_t(width) * height;
+    unsigned char* V = U + size_t(cw) * ch;
+    float* R = rows.data();
+    float* G = R + width;
+    float* B = G + width;
+
+    for (int y = 0; y < height; ++y) {
+        const Vec3* src = &framebuffer[size_t(y) * width];
+        for (int x = 0; x < width; ++x) {
+            R[x] = src[x].x;
+            G[x] = src[x].y;
+            B[x] = src[x].z;
+        }
+        rgb_to_luma_row(R, G, B, Y + size_t(y) * width, width);
+    }
+
+    // 2x2 box filter for 4:2:0 chroma; edge pixels are replicated on odd sizes
+    for (int cy = 0; cy < ch; ++cy) {
+        const Vec3* row0 = &framebuffer[size_t(2 * cy) * width];
+        const Vec3* row1 = &framebuffer[size_t(std::min(2 * cy + 1, height - 1)) * width];
+        for (int cx = 0; cx < cw; ++cx) {
+            int x0 = 2 * cx, x1 = std::min(2 * cx + 1, width - 1);
+            R[cx] = 0.25f * (clamp01(row0[x0].x) + clamp01(row0[x1].x) + clamp01(row1[x0].x) + clamp01(row1[x1].x));
+            G[cx] = 0.25f * (clamp01(row0[x0].y) + clamp01(row0[x1].y) + clamp01(row1[x0].y) + clamp01(row1[x1].y));
+            B[cx] = 0.25f * (clamp01(row0[x0].z) + clamp01(row0[x1].z) + clamp01(row1[x0].z) + clamp01(row1[x1].z));
+        }
+        rgb_to_chroma_row(R, G, B, U + size_t(cy) * cw, V + size_t(cy) * cw, cw);
+    }
+
+    std::fputs("FRAME\n", out);
+    std::fwrite(frame.data(), 1, frame.size(), out);
+    if (!owns_file) std::fflush(out);
+    if (std::ferror(out)) {
+        std::cerr << "[ERROR] Failed to write Y4M frame.\n";
+        return false;
+    }
+    return true;
+}
+
+void Y4MWriter::close() {
+    if (!out) return;
+    if (owns_file) std::fclose(out);
+    else std::fflush(out);
+    out = nullptr;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../Vec3.h"
+
+// True when the output name selects a raw YUV4MPEG2 stream ("-" or *.y4m).
+bool is_y4m_output(const std::string& filename);
+
+// Streams frames as uncompressed YUV4MPEG2 (4:2:0, BT.601 video range).
+// A path of "-" writes to stdout so frames can be piped straight into an encoder.
+class Y4MWriter {
+public:
+    Y4MWriter() = default;
+    ~Y4MWriter();
+
+    Y4MWriter(const Y4MWriter&) = delete;
+    Y4MWriter& operator=(const Y4MWriter&) = delete;
+
+    bool open(const std::string& path, int width, int height, int fps);
+    bool write_frame(const std::vector<Vec3>& framebuffer);
+    void close();
+    bool is_open() const { return out != nullptr; }
+
+private:
+    FILE* out = nullptr;
+    bool owns_file = false;
+    int width = 0, height = 0;
+    std::vector<unsigned char> frame;
+    std::vector<float> rows;
+};
+
+// RGB -> YUV row kernels (SSE2 when available, scalar otherwise).
+void rgb_to_luma_row(const float* r, const float* g, const float* b, unsigned char* y, int n);
+void rgb_to_chroma_row(const float* r, const float* g, const float* b, unsigned char* u, unsigned char* v, int n);
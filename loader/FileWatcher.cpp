@@ -0,0 +1,76 @@
+#include "FileWatcher.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(const std::string& p) : path(p) {
+    std::error_code ec;
+    lastWrite = std::filesystem::last_write_time(path, ec);
+
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd >= 0) {
+        std::filesystem::path dir = path.parent_path();
+        if (dir.empty()) dir = ".";
+        wd = inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    }
+    if (fd < 0 || wd < 0) {
+        std::cerr << "[WARNING] inotify unavailable, polling " << path.string() << " for changes.\n";
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+FileWatcher::~FileWatcher() {
+#ifdef __linux__
+    if (fd >= 0) close(fd);
+#endif
+}
+
+bool FileWatcher::pollModified() {
+    std::error_code ec;
+    auto t = std::filesystem::last_write_time(path, ec);
+    if (ec || t == lastWrite) return false;
+    lastWrite = t;
+    return true;
+}
+
+bool FileWatcher::wait(int timeoutMs) {
+#ifdef __linux__
+    if (fd >= 0) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, timeoutMs) <= 0) return false;
+
+        bool hit = false;
+        alignas(inotify_event) char buf[4096];
+        ssize_t len;
+        while ((len = read(fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                auto* ev = reinterpret_cast<inotify_event*>(p);
+                if (ev->len > 0 && path.filename() == ev->name) hit = true;
+                p += sizeof(inotify_event) + ev->len;
+            }
+        }
+        if (hit) {
+            // Editors often write in several steps; let them settle
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            while (read(fd, buf, sizeof(buf)) > 0) {}
+            pollModified();
+        }
+        return hit;
+    }
+#endif
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    do {
+        if (pollModified()) return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    } while (timeoutMs < 0 || std::chrono::steady_clock::now() < deadline);
+    return false;
+}
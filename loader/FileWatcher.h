@@ -0,0 +1,26 @@
+#pragma once
+#include <filesystem>
+#include <string>
+
+// Reports rewrites of a single file. Uses inotify on Linux (watching the
+// parent directory, so editors that save via rename are caught) and falls
+// back to polling the modification time elsewhere.
+class FileWatcher {
+public:
+    explicit FileWatcher(const std::string& path);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Waits up to timeoutMs for the file to change; true if it did.
+    bool wait(int timeoutMs);
+
+private:
+    std::filesystem::path path;
+    std::filesystem::file_time_type lastWrite;
+    int fd = -1;
+    int wd = -1;
+
+    bool pollModified();
+};
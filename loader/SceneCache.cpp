@@ -0,0 +1,51 @@
+#include "SceneCache.h"
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+static uint64_t hash_text(const std::string& text) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : text) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+std::shared_ptr<const Scene> SceneCache::get(const std::string& path) {
+    std::error_code ec;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        std::cerr << "[ERROR] Scene not found: " << path << "\n";
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(path);
+    if (it != entries.end() && it->second.mtime == mtime) {
+        ++hitCount;
+        return it->second.scene;
+    }
+
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    uint64_t contentHash = hash_text(text.str());
+    if (it != entries.end() && it->second.contentHash == contentHash) {
+        it->second.mtime = mtime;
+        ++hitCount;
+        return it->second.scene;
+    }
+
+    ++missCount;
+    std::shared_ptr<Scene> scene;
+    try {
+        scene = std::make_shared<Scene>(load_scene_from_string(text.str()));
+    } catch (const std::exception& e) {
+        std::cerr << "[ERROR] Failed to parse " << path << ": " << e.what() << "\n";
+        return nullptr;
+    }
+    entries[path] = Entry{mtime, contentHash, scene};
+    return scene;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "SceneLoader.h"
+
+// Parsed scenes keyed by path. An entry is reused while the file's
+// modification time is unchanged, or, if it changed, while the content hash
+// still matches; otherwise the file is parsed again. Thread-safe.
+class SceneCache {
+public:
+    // nullptr (with an error logged) if the file can't be read or parsed
+    std::shared_ptr<const Scene> get(const std::string& path);
+
+    size_t hits() const { return hitCount; }
+    size_t misses() const { return missCount; }
+
+private:
+    struct Entry {
+        std::filesystem::file_time_type mtime;
+        uint64_t contentHash = 0;
+        std::shared_ptr<const Scene> scene;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> entries;
+    size_t hitCount = 0, missCount = 0;
+};
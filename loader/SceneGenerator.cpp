@@ -0,0 +1,81 @@
+#include "SceneGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+struct GenRng {
+    uint32_t state;
+    explicit GenRng(uint32_t seed) : state(seed * 747796405u + 2891336453u) {}
+    float next() {
+        state = state * 1664525u + 1013904223u;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+    float range(float lo, float hi) { return lo + (hi - lo) * next(); }
+};
+
+static const float EXTENT = 4.0f;   // scene spans [-EXTENT, EXTENT] in x and z
+
+static float surface_height(float x, float z) {
+    return 0.25f * std::sin(1.3f * x) * std::cos(0.9f * z);
+}
+
+static void write_vec3(std::ostream& out, float x, float y, float z) {
+    out << x << " " << y << " " << z;
+}
+
+std::string generate_scene_text(const SceneGenParams& params) {
+    GenRng rng(params.seed);
+    std::ostringstream out;
+    out.precision(5);
+
+    out << "# Generated by beamline_gen: " << params.spheres << " spheres, " << params.triangles
+        << " triangles, " << params.lights << " lights, seed " << params.seed << "\n\n";
+    out << "[Camera]\nposition = 0 3 " << EXTENT * 1.6f << "\nlookat = 0 0 0\n\n";
+
+    for (int i = 0; i < params.lights; ++i) {
+        float angle = 6.2831853f * (i + 0.5f) / std::max(1, params.lights);
+        float intensity = 1.0f / std::sqrt(float(std::max(1, params.lights)));
+        out << "[Light" << i << "]\ntype = point\nposition = ";
+        write_vec3(out, EXTENT * 0.6f * std::cos(angle), 4.0f, EXTENT * 0.6f * std::sin(angle));
+        out << "\ncolor = ";
+        write_vec3(out, intensity, intensity, intensity);
+        out << "\n\n";
+    }
+
+    // Height field: cells x cells quads, two triangles each
+    int cells = int(std::sqrt(params.triangles / 2.0f));
+    float step = 2.0f * EXTENT / std::max(1, cells);
+    for (int cz = 0; cz < cells; ++cz) {
+        for (int cx = 0; cx < cells; ++cx) {
+            float x0 = -EXTENT + cx * step, x1 = x0 + step;
+            float z0 = -EXTENT + cz * step, z1 = z0 + step;
+            float shade = 0.5f + 0.3f * rng.next();
+            // Counter-clockwise seen from above, so normals point up
+            float quad[2][3][2] = {{{x0, z0}, {x0, z1}, {x1, z1}}, {{x0, z0}, {x1, z1}, {x1, z0}}};
+            for (int t = 0; t < 2; ++t) {
+                out << "[Tri" << cz << "_" << cx << "_" << t << "]\ntype = triangle\n";
+                for (int v = 0; v < 3; ++v) {
+                    float x = quad[t][v][0], z = quad[t][v][1];
+                    out << "v" << v << " = ";
+                    write_vec3(out, x, surface_height(x, z), z);
+                    out << "\n";
+                }
+                out << "diffuse = ";
+                write_vec3(out, shade, shade * 0.9f, shade * 0.7f);
+                out << "\nreflectivity = 0.0\n\n";
+            }
+        }
+    }
+
+    for (int i = 0; i < params.spheres; ++i) {
+        float radius = rng.range(0.05f, 0.3f);
+        float x = rng.range(-EXTENT, EXTENT), z = rng.range(-EXTENT, EXTENT);
+        bool reflective = rng.next() < params.reflectiveFraction;
+        out << "[Sphere" << i << "]\ntype = sphere\ncenter = ";
+        write_vec3(out, x, surface_height(x, z) + radius + rng.range(0.0f, 1.0f), z);
+        out << "\nradius = " << radius << "\ndiffuse = ";
+        write_vec3(out, rng.next(), rng.next(), rng.next());
+        out << "\nreflectivity = " << (reflective ? rng.range(0.3f, 0.9f) : 0.0f) << "\n\n";
+    }
+    return out.str();
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Parameters for a procedural test scene: spheres scattered over a
+// tessellated height-field surface, lit by a ring of point lights.
+struct SceneGenParams {
+    int spheres = 64;
+    int triangles = 512;          // rounded down to a whole grid (2 per cell)
+    int lights = 1;
+    float reflectiveFraction = 0.25f;
+    uint32_t seed = 1;
+};
+
+// Emits .beam text; the same parameters always produce the same scene.
+std::string generate_scene_text(const SceneGenParams& params);
@@ -35,18 +35,30 @@ inline Vec3 parse_vec3(const std::string& line) {
 
 
 Scene load_scene_from_file(const std::string& filename) {
-    Scene scene;
     std::ifstream file(filename);
     if (!file) {
         std::cerr << "Could not open scene file: " << filename << std::endl;
-        return scene;
+        return Scene();
     }
+    return load_scene_from_stream(file);
+}
 
+Scene load_scene_from_string(const std::string& text) {
+    std::istringstream ss(text);
+    return load_scene_from_stream(ss);
+}
+
+Scene load_scene_from_stream(std::istream& file) {
+    Scene scene;
     std::string line, section;
     std::map<std::string, std::string> current;
 
     auto process_section = [&](const std::string& section_name, const std::map<std::string, std::string>& data) {
-        if (section_name == "AmbientLight") {
+        if (section_name == "Camera") {
+            if (data.count("position")) scene.camera.position = parse_vec3(data.at("position"));
+            if (data.count("lookat")) scene.camera.lookat = parse_vec3(data.at("lookat"));
+        }
+        else if (section_name == "AmbientLight") {
             if (data.count("color")) {
                 scene.ambient_light = parse_vec3(data.at("color"));
             }
@@ -143,4 +155,122 @@ Scene load_scene_from_file(const std::string& filename) {
     }
 
     return scene;
-}
\ No newline at end of file
+}
+
+void CameraOverride::apply(Scene& scene) const {
+    if (has_position) {
+        scene.camera.position = position;
+    }
+    if (has_lookat) {
+        scene.camera.lookat = lookat;
+    }
+    // Validate camera position and lookat
+    if (scene.camera.position == scene.camera.lookat) {
+        std::cerr << "[WARNING] Camera position and lookat are identical. Adjusting lookat.\n";
+        scene.camera.lookat = scene.camera.position + Vec3{0, 0, -1};
+    }
+}
+
+static bool same_material(const Material& a, const Material& b) {
+    return a.diffuse_color == b.diffuse_color && a.reflectivity == b.reflectivity &&
+           a.ior == b.ior && a.emission == b.emission;
+}
+
+unsigned diff_scenes(const Scene& a, const Scene& b) {
+    unsigned change = SCENE_UNCHANGED;
+
+    if (!(a.camera.position == b.camera.position) || !(a.camera.lookat == b.camera.lookat))
+        change |= SCENE_CAMERA;
+
+    bool lights_same = a.lights.size() == b.lights.size() && a.ambient_light == b.ambient_light;
+    for (size_t i = 0; lights_same && i < a.lights.size(); ++i) {
+        lights_same = a.lights[i].position == b.lights[i].position && a.lights[i].color == b.lights[i].color;
+    }
+    if (!lights_same) change |= SCENE_LIGHTS;
+
+    if (a.spheres.size() != b.spheres.size() || a.planes.size() != b.planes.size() ||
+        a.cubes.size() != b.cubes.size() || a.triangles.size() != b.triangles.size()) {
+        return change | SCENE_GEOMETRY | SCENE_MATERIALS;
+    }
+
+    bool geometry_same = true, materials_same = true;
+    for (size_t i = 0; i < a.spheres.size(); ++i) {
+        geometry_same &= a.spheres[i].center == b.spheres[i].center && a.spheres[i].radius == b.spheres[i].radius;
+        materials_same &= same_material(a.spheres[i].material, b.spheres[i].material);
+    }
+    for (size_t i = 0; i < a.planes.size(); ++i) {
+        geometry_same &= a.planes[i].point == b.planes[i].point && a.planes[i].normal == b.planes[i].normal;
+        materials_same &= same_material(a.planes[i].material, b.planes[i].material);
+    }
+    for (size_t i = 0; i < a.cubes.size(); ++i) {
+        geometry_same &= a.cubes[i].min == b.cubes[i].min && a.cubes[i].max == b.cubes[i].max;
+        materials_same &= same_material(a.cubes[i].material, b.cubes[i].material);
+    }
+    for (size_t i = 0; i < a.triangles.size(); ++i) {
+        geometry_same &= a.triangles[i].v0 == b.triangles[i].v0 && a.triangles[i].v1 == b.triangles[i].v1 &&
+                         a.triangles[i].v2 == b.triangles[i].v2;
+        materials_same &= same_material(a.triangles[i].material, b.triangles[i].material);
+    }
+    if (!geometry_same) change |= SCENE_GEOMETRY;
+    if (!materials_same) change |= SCENE_MATERIALS;
+    return change;
+}
+
+const Material* scene_material(const Scene& scene, int id) {
+    if (id < 0) return nullptr;
+    size_t i = size_t(id);
+    if (i < scene.spheres.size()) return &scene.spheres[i].material;
+    i -= scene.spheres.size();
+    if (i < scene.planes.size()) return &scene.planes[i].material;
+    i -= scene.planes.size();
+    if (i < scene.cubes.size()) return &scene.cubes[i].material;
+    i -= scene.cubes.size();
+    if (i < scene.triangles.size()) return &scene.triangles[i].material;
+    return nullptr;
+}
+
+// FNV-1a over the raw float bits
+struct SceneHasher {
+    uint64_t h = 1469598103934665603ull;
+
+    void add(const void* data, size_t size) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    }
+    void add(float f) { add(&f, sizeof(f)); }
+    void add(const Vec3& v) { add(v.x); add(v.y); add(v.z); }
+    void add(uint64_t n) { add(&n, sizeof(n)); }
+    void add(const Material& m) { add(m.diffuse_color); add(m.reflectivity); add(m.ior); add(m.emission); }
+};
+
+uint64_t scene_geometry_hash(const Scene& scene) {
+    SceneHasher hash;
+    hash.add(scene.camera.position);
+    hash.add(scene.camera.lookat);
+
+    hash.add(uint64_t(scene.spheres.size()));
+    for (const auto& s : scene.spheres) { hash.add(s.center); hash.add(s.radius); }
+    hash.add(uint64_t(scene.planes.size()));
+    for (const auto& p : scene.planes) { hash.add(p.point); hash.add(p.normal); }
+    hash.add(uint64_t(scene.cubes.size()));
+    for (const auto& c : scene.cubes) { hash.add(c.min); hash.add(c.max); }
+    hash.add(uint64_t(scene.triangles.size()));
+    for (const auto& t : scene.triangles) { hash.add(t.v0); hash.add(t.v1); hash.add(t.v2); }
+    return hash.h;
+}
+
+uint64_t scene_hash(const Scene& scene) {
+    SceneHasher hash;
+    hash.add(scene_geometry_hash(scene));
+    for (const auto& s : scene.spheres) hash.add(s.material);
+    for (const auto& p : scene.planes) hash.add(p.material);
+    for (const auto& c : scene.cubes) hash.add(c.material);
+    for (const auto& t : scene.triangles) hash.add(t.material);
+    hash.add(uint64_t(scene.lights.size()));
+    for (const auto& l : scene.lights) { hash.add(l.position); hash.add(l.color); }
+    hash.add(scene.ambient_light);
+    return hash.h;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <cstdint>
+#include <istream>
 #include <string>
 #include <vector>
 #include "../Vec3.h"       
@@ -69,3 +71,36 @@ struct Scene {
 };
 
 Scene load_scene_from_file(const std::string& filename);
+Scene load_scene_from_string(const std::string& text);
+Scene load_scene_from_stream(std::istream& in);
+
+// Command-line camera overrides (--camera-pos / --camera-look)
+struct CameraOverride {
+    bool has_position = false;
+    bool has_lookat = false;
+    Vec3 position;
+    Vec3 lookat;
+
+    // Also nudges lookat when it coincides with the position.
+    void apply(Scene& scene) const;
+};
+
+// Which parts of a scene differ, as a bitmask of SceneChange flags.
+enum SceneChange : unsigned {
+    SCENE_UNCHANGED = 0,
+    SCENE_CAMERA    = 1 << 0,
+    SCENE_LIGHTS    = 1 << 1,   // lights and ambient light
+    SCENE_MATERIALS = 1 << 2,
+    SCENE_GEOMETRY  = 1 << 3,
+};
+unsigned diff_scenes(const Scene& before, const Scene& after);
+
+// Primitives are numbered spheres, planes, cubes, then triangles.
+// Returns nullptr when id is out of range.
+const Material* scene_material(const Scene& scene, int primitiveId);
+
+// Hash of everything that decides primary visibility (camera and geometry,
+// not lights or materials). Used to validate cached per-pixel data.
+uint64_t scene_geometry_hash(const Scene& scene);
+// Hash of the full scene description (geometry, materials, lights, camera).
+uint64_t scene_hash(const Scene& scene);
@@ -0,0 +1,279 @@
+#include "Distributed.h"
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include "Socket.h"
+#include "../cpu/RayTracer.h"
+
+enum MessageType : uint32_t {
+    MSG_SCENE  = 1,   // coordinator -> worker: scene text, camera, resolution, spp, depth, seed, sampler
+    MSG_READY  = 2,   // worker -> coordinator: scene_hash of the parsed scene
+    MSG_TILE   = 3,   // coordinator -> worker: tile rectangle
+    MSG_RESULT = 4,   // worker -> coordinator: tile rectangle + RGB floats
+    MSG_ERROR  = 5,   // worker -> coordinator: error text
+};
+
+static const int MAX_DIMENSION = 16384;
+static const int MAX_SAMPLES = 1 << 16;
+static const int MAX_TRACE_DEPTH = 256;   // reflections recurse on the stack
+
+static void put_tile(Message& msg, const Tile& t) {
+    msg.put(int32_t(t.x0));
+    msg.put(int32_t(t.y0));
+    msg.put(int32_t(t.x1));
+    msg.put(int32_t(t.y1));
+}
+
+static bool get_tile(Message& msg, Tile& t) {
+    int32_t v[4];
+    if (!msg.get(v[0]) || !msg.get(v[1]) || !msg.get(v[2]) || !msg.get(v[3])) return false;
+    t = Tile{v[0], v[1], v[2], v[3]};
+    return true;
+}
+
+static void put_vec3(Message& msg, const Vec3& v) {
+    msg.put(v.x);
+    msg.put(v.y);
+    msg.put(v.z);
+}
+
+static bool get_vec3(Message& msg, Vec3& v) {
+    return msg.get(v.x) && msg.get(v.y) && msg.get(v.z);
+}
+
+static void send_error(int fd, const std::string& text) {
+    Message err;
+    err.type = MSG_ERROR;
+    err.putString(text);
+    send_message(fd, err);
+}
+
+static void serve_coordinator(int fd) {
+    Message msg;
+    if (!recv_message(fd, msg) || msg.type != MSG_SCENE) {
+        net_close(fd);
+        return;
+    }
+
+    std::string text;
+    Vec3 position, lookat;
+    int32_t width = 0, height = 0, spp = 1, depth = 4, roulette = 3;
+    float minContribution = 0.001f;
+    uint32_t seed = 0, sampler = 0;
+    if (!msg.getString(text) || !get_vec3(msg, position) || !get_vec3(msg, lookat) ||
+        !msg.get(width) || !msg.get(height) || !msg.get(spp) || !msg.get(depth) || !msg.get(roulette) ||
+        !msg.get(minContribution) || !msg.get(seed) || !msg.get(sampler) || sampler > uint32_t(SamplerType::BlueNoise)) {
+        send_error(fd, "malformed scene message");
+        net_close(fd);
+        return;
+    }
+    // The framebuffer and accumulation buffers are sized from these, so they
+    // are checked before anything is allocated
+    std::string problem;
+    if (width <= 0 || height <= 0 || width > MAX_DIMENSION || height > MAX_DIMENSION)
+        problem = "invalid resolution";
+    else if (spp <= 0 || spp > MAX_SAMPLES)
+        problem = "spp must be between 1 and " + std::to_string(MAX_SAMPLES);
+    else if (depth <= 0 || depth > MAX_TRACE_DEPTH)
+        problem = "max-depth must be between 1 and " + std::to_string(MAX_TRACE_DEPTH);
+    else if (roulette < 0)
+        problem = "roulette must not be negative";
+    else if (!(minContribution >= 0.0f && minContribution < 1.0f))
+        problem = "min-contribution must be in [0, 1)";
+    if (!problem.empty()) {
+        send_error(fd, problem);
+        net_close(fd);
+        return;
+    }
+
+    Scene scene;
+    try {
+        scene = load_scene_from_string(text);
+    } catch (const std::exception& e) {
+        send_error(fd, std::string("scene parse failed: ") + e.what());
+        net_close(fd);
+        return;
+    }
+    scene.camera.position = position;
+    scene.camera.lookat = lookat;
+
+    RayTracer tracer(width, height, depth);
+    tracer.setRoulette(roulette);
+    tracer.setMinContribution(minContribution);
+    tracer.setSamplesPerPixel(spp);
+    tracer.setSeed(seed);
+    tracer.setSampler(SamplerType(sampler));
+    tracer.setShowProgress(false);
+
+    Message ready;
+    ready.type = MSG_READY;
+    ready.put(scene_hash(scene));
+    if (!send_message(fd, ready)) {
+        net_close(fd);
+        return;
+    }
+    std::cout << "[worker] Scene ready: " << width << "x" << height << ", " << spp << " spp\n";
+
+    int tiles = 0;
+    while (recv_message(fd, msg) && msg.type == MSG_TILE) {
+        Tile tile;
+        if (!get_tile(msg, tile) || tile.x0 < 0 || tile.y0 < 0 || tile.x1 > width || tile.y1 > height ||
+            tile.area() <= 0) {
+            send_error(fd, "invalid tile");
+            break;
+        }
+        tracer.renderRegion(scene, tile);
+
+        const auto& fb = tracer.getFramebuffer();
+        Message result;
+        result.type = MSG_RESULT;
+        put_tile(result, tile);
+        for (int y = tile.y0; y < tile.y1; ++y)
+            for (int x = tile.x0; x < tile.x1; ++x)
+                put_vec3(result, fb[size_t(y) * width + x]);
+        if (!send_message(fd, result)) break;
+        ++tiles;
+    }
+    std::cout << "[worker] Coordinator done after " << tiles << " tiles\n";
+    net_close(fd);
+}
+
+int run_worker(const std::string& address) {
+    int listenFd = net_listen(address);
+    if (listenFd < 0) return 1;
+    std::cout << "Worker listening on " << address << "\n";
+
+    for (;;) {
+        int fd = net_accept(listenFd);
+        if (fd < 0) continue;
+        std::thread(serve_coordinator, fd).detach();
+    }
+}
+
+// Work queue shared by the per-worker connection threads
+struct TileQueue {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Tile> pending;
+    size_t remaining = 0;   // tiles not yet received
+    size_t total = 0;
+    ProgressReporter* progress = nullptr;
+};
+
+static void drive_worker(const std::string& address, const Message& sceneMsg, uint64_t sceneKey,
+                         int width, int timeoutSeconds, TileQueue& queue, std::vector<Vec3>& framebuffer) {
+    int fd = net_connect(address);
+    if (fd < 0) {
+        std::cerr << "[WARNING] Couldn't connect to worker " << address << "\n";
+        return;
+    }
+    net_set_timeout(fd, timeoutSeconds);
+
+    Message msg;
+    uint64_t workerKey = 0;
+    if (!send_message(fd, sceneMsg) || !recv_message(fd, msg) || msg.type != MSG_READY ||
+        !msg.get(workerKey) || workerKey != sceneKey) {
+        std::string why = "no response";
+        if (msg.type == MSG_ERROR) msg.getString(why);
+        else if (msg.type == MSG_READY) why = "scene mismatch";
+        std::cerr << "[WARNING] Worker " << address << " rejected the scene: " << why << "\n";
+        net_close(fd);
+        return;
+    }
+
+    for (;;) {
+        Tile tile;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.cv.wait(lock, [&] { return !queue.pending.empty() || queue.remaining == 0; });
+            if (queue.remaining == 0) break;
+            tile = queue.pending.front();
+            queue.pending.pop_front();
+        }
+
+        Message job;
+        job.type = MSG_TILE;
+        put_tile(job, tile);
+
+        Tile got;
+        bool ok = send_message(fd, job) && recv_message(fd, msg) && msg.type == MSG_RESULT &&
+                  get_tile(msg, got) && got.x0 == tile.x0 && got.y0 == tile.y0 &&
+                  got.x1 == tile.x1 && got.y1 == tile.y1 &&
+                  msg.data.size() - msg.readPos == size_t(tile.area()) * 3 * sizeof(float);
+        if (!ok) {
+            std::cerr << "\n[WARNING] Worker " << address << " failed, re-issuing its tile\n";
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.pending.push_back(tile);
+            queue.cv.notify_all();
+            break;
+        }
+
+        // Tiles are disjoint, so results can be written without the lock
+        for (int y = tile.y0; y < tile.y1; ++y)
+            for (int x = tile.x0; x < tile.x1; ++x)
+                get_vec3(msg, framebuffer[size_t(y) * width + x]);
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        --queue.remaining;
+        queue.progress->add(1);
+        if (queue.remaining == 0) queue.cv.notify_all();
+    }
+    net_close(fd);
+}
+
+void render_distributed(const Scene& scene, const std::string& sceneText, int width, int height,
+                        const DistributedOptions& options, std::vector<Vec3>& framebuffer) {
+    framebuffer.assign(size_t(width) * height, Vec3());
+
+    TileQueue queue;
+    for (const Tile& t : make_tiles(width, height, options.tileSize)) queue.pending.push_back(t);
+    queue.total = queue.remaining = queue.pending.size();
+
+    Message sceneMsg;
+    sceneMsg.type = MSG_SCENE;
+    sceneMsg.putString(sceneText);
+    put_vec3(sceneMsg, scene.camera.position);
+    put_vec3(sceneMsg, scene.camera.lookat);
+    sceneMsg.put(int32_t(width));
+    sceneMsg.put(int32_t(height));
+    sceneMsg.put(int32_t(options.samplesPerPixel));
+    sceneMsg.put(int32_t(options.maxDepth));
+    sceneMsg.put(int32_t(options.rouletteBounce));
+    sceneMsg.put(options.minContribution);
+    sceneMsg.put(options.seed);
+    sceneMsg.put(uint32_t(options.sampler));
+    uint64_t sceneKey = scene_hash(scene);
+
+    std::cout << "Distributing " << queue.total << " tiles over " << options.workers.size() << " workers\n";
+    ProgressReporter progress("distributed", queue.total);
+    queue.progress = &progress;
+    std::vector<std::thread> threads;
+    for (const auto& address : options.workers) {
+        threads.emplace_back(drive_worker, address, std::cref(sceneMsg), sceneKey, width,
+                             options.timeoutSeconds, std::ref(queue), std::ref(framebuffer));
+    }
+    for (auto& t : threads) t.join();
+    progress.finish();
+
+    // Every worker is gone; finish whatever is left here
+    if (queue.remaining > 0) {
+        std::cerr << "[WARNING] No workers left, rendering " << queue.remaining << " tiles locally\n";
+        RayTracer tracer(width, height, options.maxDepth);
+        tracer.setRoulette(options.rouletteBounce);
+        tracer.setMinContribution(options.minContribution);
+        tracer.setSamplesPerPixel(options.samplesPerPixel);
+        tracer.setSeed(options.seed);
+        tracer.setSampler(options.sampler);
+        tracer.setShowProgress(false);
+        for (const Tile& tile : queue.pending) {
+            tracer.renderRegion(scene, tile);
+            const auto& fb = tracer.getFramebuffer();
+            for (int y = tile.y0; y < tile.y1; ++y)
+                for (int x = tile.x0; x < tile.x1; ++x)
+                    framebuffer[size_t(y) * width + x] = fb[size_t(y) * width + x];
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../loader/SceneLoader.h"
+#include "../cpu/Sampler.h"
+
+// Sort-first distributed rendering: the coordinator splits the frame into
+// tiles and hands them to `beamline --worker <address>` processes, one
+// connection per worker. Tiles held by a worker that disconnects or times
+// out are re-issued to the others; if every worker is lost, the remaining
+// tiles are rendered locally.
+
+struct DistributedOptions {
+    std::vector<std::string> workers;
+    int tileSize = 64;
+    int timeoutSeconds = 120;   // per-tile receive timeout
+    int samplesPerPixel = 1;
+    int maxDepth = 4;
+    int rouletteBounce = 3;
+    float minContribution = 0.001f;
+    uint32_t seed = 0;
+    SamplerType sampler = SamplerType::Stratified;
+};
+
+// Serves tile requests on address until the process is killed.
+int run_worker(const std::string& address);
+
+// sceneText is the .beam source; workers parse it themselves and adopt the
+// coordinator's (possibly overridden) camera.
+void render_distributed(const Scene& scene, const std::string& sceneText, int width, int height,
+                        const DistributedOptions& options, std::vector<Vec3>& framebuffer);
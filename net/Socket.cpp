@@ -0,0 +1,185 @@
+#include "Socket.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static const uint32_t MAX_MESSAGE_SIZE = 1u << 30;
+
+#ifndef _WIN32
+
+static bool split_host_port(const std::string& address, std::string& host, std::string& port) {
+    size_t colon = address.find_last_of(':');
+    if (colon == std::string::npos) return false;
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+    return !port.empty();
+}
+
+static bool is_unix_address(const std::string& address, sockaddr_un& sun) {
+    if (address.compare(0, 5, "unix:") != 0) return false;
+    std::string path = address.substr(5);
+    sun = sockaddr_un{};
+    sun.sun_family = AF_UNIX;
+    std::strncpy(sun.sun_path, path.c_str(), sizeof(sun.sun_path) - 1);
+    return true;
+}
+
+int net_listen(const std::string& address) {
+    sockaddr_un sun;
+    if (is_unix_address(address, sun)) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        unlink(sun.sun_path);
+        if (bind(fd, reinterpret_cast<sockaddr*>(&sun), sizeof(sun)) < 0 || listen(fd, 16) < 0) {
+            std::cerr << "[ERROR] Couldn't listen on " << address << ": " << std::strerror(errno) << "\n";
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::string host, port;
+    if (!split_host_port(address, host, port)) {
+        std::cerr << "[ERROR] Invalid address (use host:port or unix:/path): " << address << "\n";
+        return -1;
+    }
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &res) != 0) {
+        std::cerr << "[ERROR] Couldn't resolve " << address << "\n";
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) == 0 && listen(fd, 16) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    if (fd < 0) {
+        std::cerr << "[ERROR] Couldn't listen on " << address << ": " << std::strerror(errno) << "\n";
+    }
+    return fd;
+}
+
+int net_accept(int listenFd) {
+    return accept(listenFd, nullptr, nullptr);
+}
+
+int net_connect(const std::string& address) {
+    sockaddr_un sun;
+    if (is_unix_address(address, sun)) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, reinterpret_cast<sockaddr*>(&sun), sizeof(sun)) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    std::string host, port;
+    if (!split_host_port(address, host, port)) return -1;
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host.empty() ? "127.0.0.1" : host.c_str(), port.c_str(), &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+void net_close(int fd) {
+    if (fd >= 0) close(fd);
+}
+
+void net_set_timeout(int fd, int seconds) {
+    timeval tv{};
+    tv.tv_sec = seconds;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+long net_recv(int fd, void* buffer, size_t size) {
+    return long(recv(fd, buffer, size, 0));
+}
+
+static bool send_all(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t sent = send(fd, p, n, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        p += sent;
+        n -= size_t(sent);
+    }
+    return true;
+}
+
+static bool recv_all(int fd, char* p, size_t n) {
+    while (n > 0) {
+        ssize_t got = recv(fd, p, n, 0);
+        if (got <= 0) return false;
+        p += got;
+        n -= size_t(got);
+    }
+    return true;
+}
+
+#else
+
+int net_listen(const std::string&) {
+    std::cerr << "[ERROR] Networking is not supported on this platform.\n";
+    return -1;
+}
+int net_accept(int) { return -1; }
+int net_connect(const std::string&) { return -1; }
+void net_close(int) {}
+void net_set_timeout(int, int) {}
+long net_recv(int, void*, size_t) { return -1; }
+static bool send_all(int, const char*, size_t) { return false; }
+static bool recv_all(int, char*, size_t) { return false; }
+
+#endif
+
+bool net_send_all(int fd, const void* data, size_t size) {
+    return send_all(fd, static_cast<const char*>(data), size);
+}
+
+bool send_message(int fd, const Message& msg) {
+    uint32_t header[2] = {msg.type, uint32_t(msg.data.size())};
+    return send_all(fd, reinterpret_cast<const char*>(header), sizeof(header)) &&
+           send_all(fd, msg.data.data(), msg.data.size());
+}
+
+bool recv_message(int fd, Message& msg) {
+    uint32_t header[2];
+    if (!recv_all(fd, reinterpret_cast<char*>(header), sizeof(header))) return false;
+    if (header[1] > MAX_MESSAGE_SIZE) return false;
+    msg.type = header[0];
+    msg.data.resize(header[1]);
+    msg.readPos = 0;
+    return recv_all(fd, msg.data.data(), msg.data.size());
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Minimal blocking stream sockets. Addresses are "unix:/path/to.sock" for
+// Unix domain sockets or "host:port" for TCP (":port" listens on all
+// interfaces). POSIX only; the calls fail with an error message elsewhere.
+
+int net_listen(const std::string& address);
+int net_accept(int listenFd);
+int net_connect(const std::string& address);
+void net_close(int fd);
+// Receive timeout in seconds (0 = wait forever)
+void net_set_timeout(int fd, int seconds);
+bool net_send_all(int fd, const void* data, size_t size);
+// Bytes received (0 on orderly shutdown, negative on error)
+long net_recv(int fd, void* buffer, size_t size);
+
+// Length-prefixed message with a small POD reader/writer. Values are sent in
+// host byte order, which is fine for the homogeneous machines we run on.
+struct Message {
+    uint32_t type = 0;
+    std::vector<char> data;
+    size_t readPos = 0;
+
+    void putBytes(const void* p, size_t n) {
+        size_t at = data.size();
+        data.resize(at + n);
+        if (n) std::memcpy(data.data() + at, p, n);
+    }
+    template <typename T>
+    void put(const T& v) { putBytes(&v, sizeof(T)); }
+    void putString(const std::string& s) {
+        put(uint64_t(s.size()));
+        putBytes(s.data(), s.size());
+    }
+
+    template <typename T>
+    bool get(T& v) {
+        if (readPos + sizeof(T) > data.size()) return false;
+        std::memcpy(&v, data.data() + readPos, sizeof(T));
+        readPos += sizeof(T);
+        return true;
+    }
+    bool getString(std::string& s) {
+        uint64_t n;
+        if (!get(n) || readPos + n > data.size()) return false;
+        s.assign(data.data() + readPos, size_t(n));
+        readPos += size_t(n);
+        return true;
+    }
+};
+
+bool send_message(int fd, const Message& msg);
+bool recv_message(int fd, Message& msg);
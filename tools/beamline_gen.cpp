@@ -0,0 +1,57 @@
+// Procedural scene generator for scaling tests.
+//
+//   beamline_gen [--spheres N] [--triangles N] [--lights N] [--reflective F] [--seed S] [--out file.beam]
+//
+// Without --out the scene is written to stdout.
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "../loader/SceneGenerator.h"
+
+static void print_usage() {
+    std::cerr << "Usage: beamline_gen [--spheres N] [--triangles N] [--lights N] [--reflective 0..1]\n"
+              << "                    [--seed S] [--out file.beam]\n";
+}
+
+int main(int argc, char* argv[]) {
+    SceneGenParams params;
+    std::string output;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--spheres" && has_value) params.spheres = std::stoi(argv[++i]);
+            else if (arg == "--triangles" && has_value) params.triangles = std::stoi(argv[++i]);
+            else if (arg == "--lights" && has_value) params.lights = std::stoi(argv[++i]);
+            else if (arg == "--reflective" && has_value) params.reflectiveFraction = std::stof(argv[++i]);
+            else if (arg == "--seed" && has_value) params.seed = uint32_t(std::stoul(argv[++i]));
+            else if (arg == "--out" && has_value) output = argv[++i];
+            else {
+                print_usage();
+                return 1;
+            }
+        }
+    } catch (const std::exception&) {
+        print_usage();
+        return 1;
+    }
+    if (params.spheres < 0 || params.triangles < 0 || params.lights < 0) {
+        std::cerr << "[ERROR] Counts must not be negative.\n";
+        return 1;
+    }
+
+    std::string text = generate_scene_text(params);
+    if (output.empty()) {
+        std::cout << text;
+        return 0;
+    }
+    std::ofstream out(output);
+    out << text;
+    if (!out) {
+        std::cerr << "[ERROR] Couldn't write " << output << "\n";
+        return 1;
+    }
+    std::cerr << "[OK] Wrote " << output << "\n";
+    return 0;
+}